@@ -1,461 +1,714 @@
 #pragma once
 #include <Arduino.h>
 #include <FastLED.h>
-#include <ctype.h>
-#include <math.h>
+#include "expression_evaluator.h"
+#include "frame_stream.h"
+#include "native_kernels.h"
+
+#include <atomic>
+#include <mutex>
 
 #ifndef NUM_LEDS
 #define NUM_LEDS 12
 #endif
+#ifndef PATTERN_FADE_MS
+#define PATTERN_FADE_MS 250   // 슬롯 전환 크로스페이드 기본 길이 (ms, 0 = 즉시 전환)
+#endif
 
-// ★ 전방 선언 (순환 include 방지)
-extern float port_get_inport_value(const char* name);
+// 동적 패턴 컨트롤러
+//   - PatternLibrary: 저장된 패턴(NVS)과 컴파일된 바이트코드, 네이티브 커널 파라미터.
+//                     모든 LED 컨트롤러가 공유한다.
+//   - DynamicPattern: LED 컨트롤러 하나의 재생 상태 (활성 슬롯, 시작 시각, 스트림/전환 버퍼)
+//
+// 동시성: 툴 호출(툴 태스크)과 렌더 태스크가 같은 객체를 쓴다. 잠금 순서는 툴 → 프레임이고
+// 렌더 태스크는 프레임 잠금만 잡는다.
+//   - 툴 잠금(재진입 가능): 컴파일러/임시 버퍼/문자열/NVS/lastError 등 툴 측 상태
+//   - 프레임 잠금: 렌더는 프레임 하나를 그리는 동안, 툴 측은 RAM 반영(바이트코드/파라미터 복사,
+//     재생 슬롯 전환) 동안만 잡는다. 컴파일과 NVS 쓰기는 이 잠금 밖에서 하므로 프레임이 밀리지 않는다.
+// 렌더가 읽는 필드(valid, code, params, 커널 파라미터)는 두 잠금을 모두 잡고 쓰므로 한쪽만 잡고 읽어도 된다.
+#include <Preferences.h>
 
-// 경량 수식 파서 (비교 및 논리 연산자 + InPort 변수 지원)
-class ExpressionEvaluator {
+class PatternLibrary {
 public:
-  float eval(const char* expr, float theta, float t, int i) {
-    _expr = expr;
-    _pos = 0;
-    _theta = theta;
-    _t = t;
-    _i = i;
-    return _parseLogicalOr();
+  static constexpr int USER_SLOTS = 5;
+  static constexpr int BLACKOUT_SLOT = 6;
+  static constexpr int STREAM_SLOT = 7;
+
+  // Slot 8~: 네이티브 커널 (rainbow, comet, police, pulse)
+  // 이름/파라미터 정보는 LED 개수와 무관하므로 기본 링 특수화의 테이블을 사용
+  typedef NativeKernels<NUM_LEDS> Kernels;
+  static constexpr int NATIVE_SLOT_BASE = 8;
+  static constexpr int NATIVE_SLOT_COUNT = Kernels::COUNT;
+  static constexpr int LAST_SLOT = NATIVE_SLOT_BASE + NATIVE_SLOT_COUNT - 1;
+
+  enum Channel : uint8_t { CH_HUE, CH_SAT, CH_VAL, CH_COUNT };
+
+  struct Pattern {
+    bool valid = false;
+    String name;      // 패턴 이름 추가
+    String hue_expr;
+    String sat_expr;
+    String val_expr;
+    CompiledExpr code[CH_COUNT]; // 저장 시 컴파일된 바이트코드 (H, S, V)
+    uint32_t codeSerial = 0;     // code가 바뀔 때마다 새로 받는 번호 (렌더 측 오실레이터 재동기화 기준)
+
+    // 이름 있는 파라미터 (수식에서 uniform으로 참조, set_param으로 RAM에서 변경)
+    char    paramNames[EXPR_MAX_UNIFORMS][EXPR_NAME_LEN];
+    float   params[EXPR_MAX_UNIFORMS];
+    uint8_t paramCount = 0;
+
+    // 부팅 시 NVS의 수식이 현재 규칙으로 컴파일되지 않아 비활성화된 이유 (없으면 빈 문자열)
+    char loadError[64] = "";
+
+    // 실행 값 스택 요구량 (세 채널 중 최대)
+    uint8_t evalStack() const {
+      uint8_t m = 0;
+      for (int c = 0; c < CH_COUNT; c++) if (code[c].maxStack > m) m = code[c].maxStack;
+      return m;
+    }
+
+    uint8_t depth() const {
+      uint8_t m = 0;
+      for (int c = 0; c < CH_COUNT; c++) if (code[c].depth > m) m = code[c].depth;
+      return m;
+    }
+  };
+
+  typedef std::lock_guard<std::recursive_mutex> ToolLock;
+  typedef std::lock_guard<std::mutex> FrameLock;
+
+  static PatternLibrary& instance() {
+    static PatternLibrary inst;
+    return inst;
   }
 
-private:
-  const char* _expr;
-  size_t _pos;
-  float _theta, _t;
-  int _i;
+  // NVS 초기화 및 로드 (여러 번 호출돼도 한 번만 수행)
+  void begin() {
+    ToolLock tool(_toolMutex);
+    if (_inited) return;
+    _inited = true;
+
+    // 네이티브 커널 파라미터 기본값
+    for (int k = 0; k < NATIVE_SLOT_COUNT; k++) {
+      const NativeKernelInfo& info = Kernels::table()[k];
+      for (int p = 0; p < NATIVE_MAX_PARAMS; p++) _nativeParams[k][p] = info.defaults[p];
+    }
+
+    _prefs.begin("patterns", false); // Namespace: patterns
+    _loadFromNVS();
+
+    // 저장된 네이티브 파라미터 (set_param persist)
+    for (int k = 0; k < NATIVE_SLOT_COUNT; k++) {
+      String key = "n" + String(NATIVE_SLOT_BASE + k) + "_pv";
+      if (_prefs.isKey(key.c_str())) _prefs.getBytes(key.c_str(), _nativeParams[k], sizeof(_nativeParams[k]));
+    }
+  }
+
+  // 패턴 저장 (Slot 1~5)
+  // 수식은 여기서 컴파일되며, 문법 오류/깊이 초과 시 저장하지 않는다 (lastError() 참고)
+  // paramNames/paramValues: 이름 있는 파라미터와 초기값 (선택)
+  bool savePattern(int slot, const char* name, const char* hue, const char* sat, const char* val,
+                   const char* const* paramNames = nullptr, const float* paramValues = nullptr,
+                   uint8_t paramCount = 0) {
+    ToolLock tool(_toolMutex);
+    if (slot < 1 || slot > USER_SLOTS) {
+      snprintf(_lastError, sizeof(_lastError), "invalid slot");
+      return false;
+    }
+    if (paramCount > EXPR_MAX_UNIFORMS) {
+      snprintf(_lastError, sizeof(_lastError), "too many params (max %d)", EXPR_MAX_UNIFORMS);
+      return false;
+    }
+    for (uint8_t k = 0; k < paramCount; k++) {
+      if (!_validParamName(paramNames[k], _scratchNames, k)) return false;
+      memcpy(_scratchNames[k], paramNames[k], strlen(paramNames[k]) + 1);
+    }
+
+    const char* exprs[CH_COUNT] = { hue, sat, val };
+    if (!_compileAll(exprs, _scratch, _scratchNames, paramCount)) return false;
+
+    Pattern& p = _patterns[slot];
+    p.name = name;
+    p.hue_expr = hue;
+    p.sat_expr = sat;
+    p.val_expr = val;
+    {
+      // 렌더가 읽는 필드만 프레임 사이에 교체 (복사만, 할당/컴파일 없음)
+      FrameLock frame(_frameMutex);
+      p.valid = true;
+      p.loadError[0] = '\0';
+      for (int c = 0; c < CH_COUNT; c++) p.code[c] = _scratch[c];
+      p.codeSerial = ++_codeSerial;
+      p.paramCount = paramCount;
+      for (uint8_t k = 0; k < paramCount; k++) {
+        memcpy(p.paramNames[k], _scratchNames[k], EXPR_NAME_LEN);
+        p.params[k] = paramValues ? paramValues[k] : 0.0f;
+      }
+    }
 
-  char _peek() const {
-    return _expr[_pos];
+    // NVS 저장 (프레임 잠금 밖)
+    _saveToNVS(slot);
+    touch();
+    return true;
   }
 
-  char _consume() {
-    return _expr[_pos++];
+  // 패턴 목록
+  int getMaxSlots() const { return BLACKOUT_SLOT; } // 1-5: User, 6: Blackout
+
+  // 반환된 패턴은 툴 잠금(툴 측) 또는 프레임 잠금(렌더 측)을 잡은 동안만 읽는다
+  const Pattern* getPattern(int slot) const {
+    if (slot >= 1 && slot <= USER_SLOTS) return &_patterns[slot];
+    return nullptr;
   }
 
-  void _skipWhitespace() {
-    while (isspace(_peek())) _pos++;
+  // 실행 가능한 슬롯인지 (사용자 슬롯은 저장된 경우만, 내장 슬롯은 항상)
+  bool isPlayable(int slot) const {
+    if (slot >= 1 && slot <= USER_SLOTS) return _patterns[slot].valid;
+    return slot > USER_SLOTS && slot <= LAST_SLOT;
   }
 
-  // 논리 OR: logicalOr → logicalAnd ('||' logicalAnd)*
-  float _parseLogicalOr() {
-    _skipWhitespace();
-    float result = _parseLogicalAnd();
-    
-    while (true) {
-      _skipWhitespace();
-      if (_peek() == '|' && _expr[_pos + 1] == '|') {
-        _consume(); _consume();
-        float right = _parseLogicalAnd();
-        result = (result != 0 || right != 0) ? 1.0f : 0.0f;
-      } else {
-        break;
-      }
+  // 네이티브 커널 조회 (slot 8~)
+  static const NativeKernelInfo* getNativeKernel(int slot) {
+    if (slot < NATIVE_SLOT_BASE || slot > LAST_SLOT) return nullptr;
+    return &Kernels::table()[slot - NATIVE_SLOT_BASE];
+  }
+
+  const float* getNativeParams(int slot) const {
+    if (slot < NATIVE_SLOT_BASE || slot > LAST_SLOT) return nullptr;
+    return _nativeParams[slot - NATIVE_SLOT_BASE];
+  }
+
+  // 네이티브 커널 파라미터 인덱스 (없는 슬롯/이름이면 -1)
+  static int nativeParamIndex(int slot, const char* name) {
+    const NativeKernelInfo* info = getNativeKernel(slot);
+    if (!info || !name) return -1;
+    for (int p = 0; p < info->paramCount; p++) {
+      if (strcmp(info->paramNames[p], name) == 0) return p;
     }
-    return result;
-  }
-
-  // 논리 AND: logicalAnd → comparison ('&&' comparison)*
-  float _parseLogicalAnd() {
-    _skipWhitespace();
-    float result = _parseComparison();
-    
-    while (true) {
-      _skipWhitespace();
-      if (_peek() == '&' && _expr[_pos + 1] == '&') {
-        _consume(); _consume();
-        float right = _parseComparison();
-        result = (result != 0 && right != 0) ? 1.0f : 0.0f;
-      } else {
-        break;
-      }
+    return -1;
+  }
+
+  // 네이티브 커널 파라미터 변경 (RAM, 다음 프레임부터 반영)
+  bool setNativeParam(int slot, const char* name, float value) {
+    int p = nativeParamIndex(slot, name);
+    if (p < 0) return false;
+    ToolLock tool(_toolMutex);
+    FrameLock frame(_frameMutex);
+    _nativeParams[slot - NATIVE_SLOT_BASE][p] = value;
+    touch();
+    return true;
+  }
+
+  // 파라미터 변경 (RAM만, 파싱/컴파일 없이 다음 프레임부터 반영)
+  // 사용자 슬롯은 패턴 파라미터, 네이티브 슬롯은 커널 파라미터
+  bool setParam(int slot, const char* name, float value) {
+    ToolLock tool(_toolMutex);
+    float* dst = _paramValue(slot, name);
+    if (!dst) return false;
+    FrameLock frame(_frameMutex);
+    *dst = value;
+    touch();
+    return true;
+  }
+
+  // setParam이 성공할지 미리 확인 (여러 파라미터를 모두 확인한 뒤 적용할 때, 실패 원인은 lastError())
+  bool hasParam(int slot, const char* name) {
+    ToolLock tool(_toolMutex);
+    return _paramValue(slot, name) != nullptr;
+  }
+
+  // 현재 파라미터 값을 NVS에 저장 (슬롯당 키 하나)
+  bool persistParams(int slot) {
+    ToolLock tool(_toolMutex);
+    if (getNativeKernel(slot)) {
+      String key = "n" + String(slot) + "_pv";
+      return _prefs.putBytes(key.c_str(), _nativeParams[slot - NATIVE_SLOT_BASE], sizeof(_nativeParams[0])) > 0;
     }
-    return result;
-  }
-
-  // 비교: comparison → expression (('<' | '>' | '<=' | '>=' | '==' | '!=') expression)?
-  float _parseComparison() {
-    _skipWhitespace();
-    float result = _parseExpression();
-    
-    _skipWhitespace();
-    char op1 = _peek();
-    
-    if (op1 == '<' || op1 == '>' || op1 == '=' || op1 == '!') {
-      _consume();
-      char op2 = _peek();
-      
-      // <=, >=, ==, !=
-      if ((op1 == '<' && op2 == '=') || 
-          (op1 == '>' && op2 == '=') || 
-          (op1 == '=' && op2 == '=') || 
-          (op1 == '!' && op2 == '=')) {
-        _consume();
-        float right = _parseExpression();
-        
-        if (op1 == '<') return (result <= right) ? 1.0f : 0.0f;
-        if (op1 == '>') return (result >= right) ? 1.0f : 0.0f;
-        if (op1 == '=') return (fabs(result - right) < 0.0001f) ? 1.0f : 0.0f;
-        if (op1 == '!') return (fabs(result - right) >= 0.0001f) ? 1.0f : 0.0f;
+    if (slot < 1 || slot > USER_SLOTS || !_patterns[slot].valid) return false;
+    _saveParamValues(slot);
+    return true;
+  }
+
+  // 마지막 savePattern/setParam 실패 원인 (실패한 호출과 같은 툴 잠금 안에서 읽는다)
+  const char* lastError() const { return _lastError; }
+
+  // 저장된 수식을 다시 컴파일해 명령(pc)별 원문 위치를 얻는다 (프로파일 결과 표시용, 툴 태스크 전용)
+  // 반환: false = 빈 슬롯이거나 실행 중인 바이트코드와 달라짐 (그 사이 패턴이 바뀜)
+  bool sourceSpans(int slot, Channel ch, ExprSpan* spans) {
+    ToolLock tool(_toolMutex);
+    const Pattern* p = getPattern(slot);
+    if (!p || !p->valid) return false;
+    const String& src = (ch == CH_HUE) ? p->hue_expr : (ch == CH_SAT) ? p->sat_expr : p->val_expr;
+    CompiledExpr& tmp = _scratch[ch];
+    if (!_evaluator.compile(src.c_str(), tmp, p->paramNames, p->paramCount, spans)) return false;
+    const CompiledExpr& live = p->code[ch];
+    return tmp.codeLen == live.codeLen &&
+           memcmp(tmp.code, live.code, sizeof(ExprInstr) * live.codeLen) == 0;
+  }
+
+  // 슬롯 테이블/활성 슬롯이 바뀔 때마다 증가 (상태 응답 캐시 무효화용)
+  uint32_t revision() const { return _revision.load(std::memory_order_relaxed); }
+  void touch() { _revision.fetch_add(1, std::memory_order_relaxed); }
+
+  std::recursive_mutex& toolMutex() { return _toolMutex; }
+  std::mutex& frameMutex() { return _frameMutex; }
+
+private:
+  PatternLibrary() {}
+
+  bool _inited = false;
+  Pattern _patterns[USER_SLOTS + 1]; // Index 1~5 used
+  std::atomic<uint32_t> _revision{0};
+  uint32_t _codeSerial = 0;           // 마지막으로 발급한 Pattern::codeSerial (툴 잠금)
+  std::recursive_mutex _toolMutex;
+  std::mutex _frameMutex;
+  ExpressionEvaluator _evaluator;     // 컴파일러 (툴 태스크에서만 사용)
+  CompiledExpr _scratch[CH_COUNT];    // 컴파일 임시 버퍼 (스택 대신)
+  char _scratchNames[EXPR_MAX_UNIFORMS][EXPR_NAME_LEN];
+  char _lastError[64] = "";
+  float _nativeParams[NATIVE_SLOT_COUNT][NATIVE_MAX_PARAMS];
+  Preferences _prefs;
+
+  void _loadFromNVS() {
+    for (int i = 1; i <= USER_SLOTS; i++) {
+      String keyPrefix = "p" + String(i) + "_";
+      if (_prefs.isKey((keyPrefix + "valid").c_str())) {
+        _patterns[i].valid = _prefs.getBool((keyPrefix + "valid").c_str());
+        _patterns[i].name = _prefs.getString((keyPrefix + "name").c_str(), "Pattern " + String(i));
+        _patterns[i].hue_expr = _prefs.getString((keyPrefix + "hue").c_str(), "0");
+        _patterns[i].sat_expr = _prefs.getString((keyPrefix + "sat").c_str(), "1");
+        _patterns[i].val_expr = _prefs.getString((keyPrefix + "val").c_str(), "0.5");
+
+        _loadParams(i);
+
+        if (_patterns[i].valid) {
+          const char* exprs[CH_COUNT] = {
+            _patterns[i].hue_expr.c_str(), _patterns[i].sat_expr.c_str(), _patterns[i].val_expr.c_str()
+          };
+          if (_compileAll(exprs, _patterns[i].code, _patterns[i].paramNames, _patterns[i].paramCount)) {
+            _patterns[i].codeSerial = ++_codeSerial;
+            continue;
+          }
+          // 이전 버전에서 저장된 수식이 현재 규칙으로 컴파일되지 않으면 비활성화 (slot_status로 보고)
+          Serial.printf("[PATTERN] Slot %d disabled: %s\n", i, _lastError);
+          memcpy(_patterns[i].loadError, _lastError, sizeof(_patterns[i].loadError));
+          _patterns[i].valid = false;
+        }
       }
-      // <, >
-      else if (op1 == '<' || op1 == '>') {
-        float right = _parseExpression();
-        if (op1 == '<') return (result < right) ? 1.0f : 0.0f;
-        if (op1 == '>') return (result > right) ? 1.0f : 0.0f;
+    }
+  }
+
+  // 슬롯/이름에 해당하는 파라미터 저장 위치 (없으면 _lastError를 채우고 nullptr, 툴 잠금 안에서 호출)
+  float* _paramValue(int slot, const char* name) {
+    if (!name) name = "";
+    if (getNativeKernel(slot)) {
+      int p = nativeParamIndex(slot, name);
+      if (p >= 0) return &_nativeParams[slot - NATIVE_SLOT_BASE][p];
+    } else if (slot < 1 || slot > USER_SLOTS || !_patterns[slot].valid) {
+      snprintf(_lastError, sizeof(_lastError), "slot %d has no pattern", slot);
+      return nullptr;
+    } else {
+      Pattern& p = _patterns[slot];
+      for (uint8_t k = 0; k < p.paramCount; k++) {
+        if (strcmp(p.paramNames[k], name) == 0) return &p.params[k];
       }
     }
-    
-    return result;
-  }
-
-  // 파싱: expression → term (('+' | '-') term)*
-  float _parseExpression() {
-    _skipWhitespace();
-    float result = _parseTerm();
-    
-    while (true) {
-      _skipWhitespace();
-      char op = _peek();
-      if (op == '+' || op == '-') {
-        _consume();
-        float right = _parseTerm();
-        result = (op == '+') ? (result + right) : (result - right);
-      } else {
-        break;
+    snprintf(_lastError, sizeof(_lastError), "unknown param '%.20s'", name);
+    return nullptr;
+  }
+
+  // 파라미터 이름: "p<i>_pn" = 쉼표 구분 이름, 값: "p<i>_pv" = float 배열
+  void _loadParams(int slot) {
+    Pattern& p = _patterns[slot];
+    p.paramCount = 0;
+    String names = _prefs.getString(("p" + String(slot) + "_pn").c_str(), "");
+    const char* s = names.c_str();
+    while (*s && p.paramCount < EXPR_MAX_UNIFORMS) {
+      const char* end = strchr(s, ',');
+      size_t len = end ? (size_t)(end - s) : strlen(s);
+      if (len > 0 && len < EXPR_NAME_LEN) {
+        memcpy(p.paramNames[p.paramCount], s, len);
+        p.paramNames[p.paramCount][len] = '\0';
+        p.params[p.paramCount] = 0.0f;
+        p.paramCount++;
       }
+      if (!end) break;
+      s = end + 1;
     }
-    return result;
-  }
-
-  // term → factor (('*' | '/' | '%') factor)*
-  float _parseTerm() {
-    _skipWhitespace();
-    float result = _parseFactor();
-    
-    while (true) {
-      _skipWhitespace();
-      char op = _peek();
-      if (op == '*' || op == '/' || op == '%') {
-        _consume();
-        float right = _parseFactor();
-        if (op == '*') {
-          result *= right;
-        } else if (op == '/') {
-          result = (right != 0) ? (result / right) : 0;
-        } else if (op == '%') {
-          result = fmod(result, right);
-        }
-      } else {
-        break;
+    if (p.paramCount > 0) {
+      _prefs.getBytes(("p" + String(slot) + "_pv").c_str(), p.params, p.paramCount * sizeof(float));
+    }
+  }
+
+  void _saveParamValues(int slot) {
+    const Pattern& p = _patterns[slot];
+    _prefs.putBytes(("p" + String(slot) + "_pv").c_str(), p.params, p.paramCount * sizeof(float));
+  }
+
+  // 식별자 형식, 내장 변수와 중복, 앞선 이름과 중복 검사
+  bool _validParamName(const char* name, const char (*prev)[EXPR_NAME_LEN], uint8_t prevCount) {
+    size_t len = name ? strlen(name) : 0;
+    bool ok = len > 0 && len < EXPR_NAME_LEN && (isalpha((unsigned char)name[0]) || name[0] == '_');
+    for (size_t k = 1; ok && k < len; k++) ok = isalnum((unsigned char)name[k]) || name[k] == '_';
+    if (!ok) {
+      snprintf(_lastError, sizeof(_lastError), "invalid param name '%.20s'", name ? name : "");
+      return false;
+    }
+    static const char* const kReserved[] = { "theta", "t", "i", "pi" };
+    for (const char* r : kReserved) {
+      if (strcmp(name, r) == 0) {
+        snprintf(_lastError, sizeof(_lastError), "param name '%s' is reserved", name);
+        return false;
       }
     }
-    return result;
-  }
-
-  // factor → '!' factor | unary
-  float _parseFactor() {
-    _skipWhitespace();
-    
-    // 논리 NOT
-    if (_peek() == '!') {
-      _consume();
-      _skipWhitespace();
-      // != 연산자와 구분 (다음이 =가 아닐 때만 NOT)
-      if (_peek() != '=') {
-        return (_parseFactor() == 0) ? 1.0f : 0.0f;
-      } else {
-        // != 연산자인 경우 위치 되돌림
-        _pos--;
-        return _parseUnary();
+    for (uint8_t k = 0; k < prevCount; k++) {
+      if (strcmp(prev[k], name) == 0) {
+        snprintf(_lastError, sizeof(_lastError), "duplicate param '%.20s'", name);
+        return false;
       }
     }
-    
-    return _parseUnary();
-  }
-
-  float _parseUnary() {
-    _skipWhitespace();
-    
-    // 음수
-    if (_peek() == '-') {
-      _consume();
-      return -_parseUnary();
-    }
-    
-    // 괄호
-    if (_peek() == '(') {
-      _consume();
-      float result = _parseLogicalOr();
-      _skipWhitespace();
-      if (_peek() == ')') _consume();
-      return result;
-    }
-    
-    // 숫자
-    if (isdigit(_peek()) || _peek() == '.') {
-      return _parseNumber();
-    }
-    
-    // 변수 또는 함수
-    if (isalpha(_peek()) || _peek() == '_') {
-      return _parseIdentifier();
-    }
-    
-    return 0;
-  }
-
-  float _parseNumber() {
-    size_t start = _pos;
-    while (isdigit(_peek()) || _peek() == '.') _pos++;
-    
-    char buffer[32];
-    size_t len = min((size_t)31, _pos - start);
-    strncpy(buffer, _expr + start, len);
-    buffer[len] = '\0';
-    
-    return atof(buffer);
-  }
-
-  float _parseIdentifier() {
-    size_t start = _pos;
-    while (isalnum(_peek()) || _peek() == '_') _pos++;
-    
-    char buffer[32];
-    size_t len = min((size_t)31, _pos - start);
-    strncpy(buffer, _expr + start, len);
-    buffer[len] = '\0';
-    
-    _skipWhitespace();
-    
-    // 함수 호출
-    if (_peek() == '(') {
-      _consume();
-      float arg1 = _parseLogicalOr();
-      _skipWhitespace();
-      
-      // 2개 인자 함수
-      if (_peek() == ',') {
-        _consume();
-        float arg2 = _parseLogicalOr();
-        _skipWhitespace();
-        if (_peek() == ')') _consume();
-        
-        if (strcmp(buffer, "max") == 0) return max(arg1, arg2);
-        if (strcmp(buffer, "min") == 0) return min(arg1, arg2);
-        if (strcmp(buffer, "mod") == 0) return fmod(arg1, arg2);
-        if (strcmp(buffer, "pow") == 0) return pow(arg1, arg2);
-        return 0;
+    return true;
+  }
+
+  bool _compileAll(const char* const* exprs, CompiledExpr* out,
+                   const char (*paramNames)[EXPR_NAME_LEN], uint8_t paramCount) {
+    static const char* const kChannelNames[CH_COUNT] = { "hue", "saturation", "brightness" };
+    for (int c = 0; c < CH_COUNT; c++) {
+      if (!_evaluator.compile(exprs[c], out[c], paramNames, paramCount)) {
+        snprintf(_lastError, sizeof(_lastError), "%s: %s at position %d",
+                 kChannelNames[c], _evaluator.error(), _evaluator.errorPos());
+        return false;
       }
-      
-      // 1개 인자 함수
-      if (_peek() == ')') _consume();
-      
-      if (strcmp(buffer, "sin") == 0) return sin(arg1);
-      if (strcmp(buffer, "cos") == 0) return cos(arg1);
-      if (strcmp(buffer, "tan") == 0) return tan(arg1);
-      if (strcmp(buffer, "abs") == 0) return fabs(arg1);
-      if (strcmp(buffer, "sqrt") == 0) return sqrt(arg1);
-      if (strcmp(buffer, "floor") == 0) return floor(arg1);
-      if (strcmp(buffer, "ceil") == 0) return ceil(arg1);
-      return 0;
-    }
-    
-    // ===== 내장 변수 =====
-    if (strcmp(buffer, "theta") == 0) return _theta;
-    if (strcmp(buffer, "t") == 0) return _t;
-    if (strcmp(buffer, "i") == 0) return (float)_i;
-    if (strcmp(buffer, "pi") == 0) return PI;
-    
-    // ===== ★ InPort 변수 자동 조회 =====
-    float val = port_get_inport_value(buffer);
-    if (!isnan(val)) {
-      return val;
-    }
-    
-    return 0;
+    }
+    return true;
   }
-};
 
-// 동적 패턴 컨트롤러
-#include <Preferences.h>
+  void _saveToNVS(int slot) {
+    String keyPrefix = "p" + String(slot) + "_";
+    _prefs.putBool((keyPrefix + "valid").c_str(), _patterns[slot].valid);
+    _prefs.putString((keyPrefix + "name").c_str(), _patterns[slot].name);
+    _prefs.putString((keyPrefix + "hue").c_str(), _patterns[slot].hue_expr);
+    _prefs.putString((keyPrefix + "sat").c_str(), _patterns[slot].sat_expr);
+    _prefs.putString((keyPrefix + "val").c_str(), _patterns[slot].val_expr);
+
+    String names;
+    for (uint8_t k = 0; k < _patterns[slot].paramCount; k++) {
+      if (k) names += ",";
+      names += _patterns[slot].paramNames[k];
+    }
+    _prefs.putString((keyPrefix + "pn").c_str(), names);
+    _saveParamValues(slot);
+  }
+};
 
 class DynamicPattern {
 public:
-  struct Pattern {
-    bool valid = false;
-    String name;      // 패턴 이름 추가
-    String hue_expr;
-    String sat_expr;
-    String val_expr;
-  };
+  typedef PatternLibrary Lib;
 
-  // NVS 초기화 및 로드
-  void begin() {
-    _prefs.begin("patterns", false); // Namespace: patterns
-    _loadFromNVS();
-  }
+  // 수식 프로파일 버퍼 (채널별 명령 단위 횟수/시간)
+  struct Profile {
+    ExprProfile ch[Lib::CH_COUNT];
+    uint32_t frames;
+  };
 
-  // 패턴 저장 (Slot 1~5)
-  bool savePattern(int slot, const char* name, const char* hue, const char* sat, const char* val) {
-    if (slot < 1 || slot > 5) return false;
-    
-    _patterns[slot].valid = true;
-    _patterns[slot].name = name;
-    _patterns[slot].hue_expr = hue;
-    _patterns[slot].sat_expr = sat;
-    _patterns[slot].val_expr = val;
-
-    // NVS 저장
-    _saveToNVS(slot);
-    return true;
+  // 컨트롤러 기하 정보 연결 (LED 수, N에 특수화된 커널 테이블, 스트림 버퍼 저장소, 전환 버퍼 numLeds개)
+  void attach(uint16_t numLeds, const NativeKernelInfo* kernels, uint8_t* streamStorage, CRGB* fadeStorage) {
+    _numLeds = numLeds;
+    _kernels = kernels;
+    _stream.attach(streamStorage, (size_t)numLeds * 3);
+    _fadeFrom = fadeStorage;
   }
 
-  // 패턴 실행 (Slot 0 ~ 6)
+  // 패턴 실행 (Slot 0 ~ 11)
   // Slot 0: 패턴 중지 (기본 눈 깜빡임으로 복귀)
   // Slot 6: 완전 소등 (Blackout)
-  bool executePattern(int slot, float duration_sec) {
-    if (slot == 0) {
-      stop();
-      return true;
-    }
-    
-    // Slot 1~5: Saved Patterns, Slot 6: Blackout
-    if (slot < 1 || slot > 6) return false;
-    
-    // Slot 6 doesn't need validation check (it's hardcoded logic)
-    if (slot != 6 && !_patterns[slot].valid) return false;
-
-    _current_slot = slot;
-    _current_duration = duration_sec;
-    _active = true;
-    _start_time = millis();
-    return true;
+  // Slot 7: 원시 프레임 스트리밍 (push_frame으로 받은 RGB 그대로 표시)
+  // Slot 8~11: 네이티브 커널
+  // fadeMs: 직전 화면에서 새 슬롯으로 크로스페이드하는 시간 (0 = 즉시, Slot 0은 항상 즉시)
+  bool executePattern(int slot, float duration_sec, uint16_t fadeMs = PATTERN_FADE_MS) {
+    Lib::FrameLock frame(Lib::instance().frameMutex());
+    return _start(slot, duration_sec, fadeMs);
   }
 
   // 다음 유효한 슬롯 실행 (버튼 제어용)
-  // 0 -> 1 -> 3 -> 5 -> 0 ... 순환 (Slot 6 제외)
+  // 0 -> 1 -> 3 -> 5 -> 8 -> ... -> 11 -> 0 ... 순환 (빈 슬롯, Slot 6/7 제외)
   void cycleNextSlot() {
-    int start = (_current_slot == 0) ? 0 : _current_slot;
-    int next = start;
-    
-    // 최대 6번(0~5) 시도하여 다음 유효한 슬롯 찾기
-    for (int i = 0; i < 6; i++) {
-      next = (next + 1) > 5 ? 0 : (next + 1);
-      
+    Lib& lib = Lib::instance();
+    Lib::FrameLock frame(lib.frameMutex());
+    int next = _current_slot;
+    if (next == Lib::BLACKOUT_SLOT || next == Lib::STREAM_SLOT) next = Lib::LAST_SLOT; // 다음은 IDLE
+
+    // 전체 슬롯 수만큼 시도하여 다음 유효한 슬롯 찾기
+    for (int i = 0; i <= Lib::LAST_SLOT; i++) {
+      next = (next + 1) > Lib::LAST_SLOT ? 0 : (next + 1);
+      if (next == Lib::BLACKOUT_SLOT) next = Lib::NATIVE_SLOT_BASE; // Blackout/Stream 건너뜀
+
       if (next == 0) {
         // IDLE로 복귀
-        stop();
+        _stop();
         return;
       }
-      
-      if (_patterns[next].valid) {
+
+      if (lib.isPlayable(next)) {
         // 유효한 패턴 발견 -> 무한 실행
-        executePattern(next, 0.0f);
+        _start(next, 0.0f, PATTERN_FADE_MS);
         return;
       }
     }
-    
-    // 유효한 패턴이 하나도 없으면 IDLE 유지
-    stop();
-  }
 
-  // 패턴 목록
-  int getMaxSlots() const { return 6; } // 1-5: User, 6: Blackout
-  
-  const Pattern* getPattern(int slot) const {
-    if (slot >= 1 && slot <= 5) return &_patterns[slot];
-    return nullptr;
+    // 유효한 패턴이 하나도 없으면 IDLE 유지
+    _stop();
   }
 
   void stop() {
-    _active = false;
-    _current_slot = 0;
+    Lib::FrameLock frame(Lib::instance().frameMutex());
+    _stop();
   }
 
   bool isActive() const { return _active; }
+  bool isStreaming() const { return _active && _current_slot == Lib::STREAM_SLOT; }
+
+  // 원시 프레임 입력 (Slot 7에서 표시)
+  FrameStream& frameStream() { return _stream; }
+  int getCurrentSlot() const { return _current_slot; }
+
+  // 프로파일 시작: 다음 frames 프레임 동안 수식 실행을 계측 (렌더 태스크가 prof를 채움)
+  // 계측하지 않는 프레임은 run<false> 경로라 비용이 없다.
+  // prof는 profileDone()이 참이 되거나 cancelProfile()이 돌아온 뒤에는 렌더 태스크가 건드리지 않는다
+  void armProfile(Profile* prof, uint16_t frames) {
+    Lib::FrameLock frame(Lib::instance().frameMutex());
+    for (int c = 0; c < Lib::CH_COUNT; c++) prof->ch[c].clear();
+    prof->frames = 0;
+    _profile = prof;
+    _profileLeft = frames;
+  }
+  bool profileDone() const { return _profileLeft == 0; }
+  void cancelProfile() {
+    Lib::FrameLock frame(Lib::instance().frameMutex());
+    _profileLeft = 0;
+  }
 
   void update(CRGB* leds, uint32_t now) {
+    Lib::FrameLock frame(Lib::instance().frameMutex());  // 툴 측 교체와 프레임이 섞이지 않도록
     if (!_active || _current_slot == 0) return;
-    
-    // 시간 체크
-    float elapsed = (now - _start_time) / 1000.0f;
-    
+
+    // 시간 체크 (정수 ms가 기준 시간축, float t는 오실레이터가 아닌 항에만 사용)
+    const uint32_t elapsedMs = now - _start_time;
+
     // Duration이 0보다 크면 시간 체크
-    if (_current_duration > 0 && elapsed >= _current_duration) {
-      stop();
+    if (_current_duration > 0 && elapsedMs / 1000.0f >= _current_duration) {
+      _stop();
       return;
     }
 
-    // Slot 6: Blackout (모두 끄기)
-    if (_current_slot == 6) {
-      FastLED.clear();
-      // Note: EyeController::update calls FastLED.show() after this returns
-      // but to be safe/consistent with pattern logic, we fill leds buffer.
-      // EyeController calls FastLED.show() if isActive() is true.
-      // So just clearing 'leds' array is enough.
-      for(int i=0; i<NUM_LEDS; i++) leds[i] = CRGB::Black;
-      return;
+    // 전환 후 첫 프레임: 지금 링에 표시된 프레임(이전 패턴, 눈 깜빡임, 페이드 도중 화면)을 보관
+    if (_fadePending) {
+      _fadePending = false;
+      memcpy(_fadeFrom, leds, sizeof(CRGB) * _numLeds);
+      _fadeStart = now;
+      _fading = true;
     }
-    
-    float t = elapsed;
-    const Pattern& p = _patterns[_current_slot];
-    
-    for (int i = 0; i < NUM_LEDS; i++) {
-      float theta = (2.0f * PI * i) / NUM_LEDS;
-      
-      float h = _evaluator.eval(p.hue_expr.c_str(), theta, t, i);
-      float s = _evaluator.eval(p.sat_expr.c_str(), theta, t, i);
-      float v = _evaluator.eval(p.val_expr.c_str(), theta, t, i);
-      
-      // 정규화
-      h = fmod(h, 2 * PI);
-      if (h < 0) h += 2 * PI;
-      
-      s = constrain(s, 0.0f, 1.0f);
-      v = constrain(fabs(v), 0.0f, 1.0f);
-      
-      // HSV → RGB
-      uint8_t hue_byte = (uint8_t)((h / (2 * PI)) * 255);
-      uint8_t sat_byte = (uint8_t)(s * 255);
-      uint8_t val_byte = (uint8_t)(v * 255);
-      
-      leds[i] = CHSV(hue_byte, sat_byte, val_byte);
+
+    _renderSlot(leds, _current_slot, elapsedMs, _render[_cur], _profileLeft > 0);
+    if (_fading) {
+      // 나가는 슬롯도 페이드가 끝날 때까지 계속 움직인다 (페이드 동안은 두 슬롯을 모두 그린다).
+      // 나가는 쪽이 눈 깜빡임이거나 페이드 도중 다시 전환했으면 위에서 보관한 화면을 그대로 쓴다.
+      if (_outSlot != 0) _renderSlot(_fadeFrom, _outSlot, now - _outStart, _render[_cur ^ 1], false);
+      _blendFade(leds, now);
     }
   }
 
 private:
-  Pattern _patterns[6]; // Index 1~5 used
-  int _current_slot = 0;
+  uint16_t _numLeds = 0;
+  const NativeKernelInfo* _kernels = nullptr;  // 이 컨트롤러의 LED 수로 특수화된 테이블
+  // 재생 상태는 프레임 잠금 안에서 바뀐다. 슬롯/활성 여부는 툴 측이 잠금 없이 조회하므로 atomic.
+  std::atomic<int> _current_slot{0};
   float _current_duration = 0.0f;
-  bool _active = false;
+  std::atomic<bool> _active{false};
   uint32_t _start_time = 0;
-  ExpressionEvaluator _evaluator;
-  Preferences _prefs;
+  FrameStream _stream;
+
+  // 슬롯 하나를 그리는 동안 프레임 사이에 유지되는 수식 상태
+  // 크로스페이드 중에는 나가는 슬롯도 계속 그리므로 두 벌을 두고 전환할 때 역할을 바꾼다.
+  struct SlotRender {
+    ExprOscState osc[Lib::CH_COUNT][EXPR_MAX_OSC];  // 채널별 오실레이터 상태
+    uint32_t oscCodeSerial = 0;   // 오실레이터 상태를 맞춘 Pattern::codeSerial
+    ExprFilterState filt[Lib::CH_COUNT][EXPR_MAX_FILTERS];  // 채널별 상태 함수 (smooth 등)
+    uint8_t filterLayout[Lib::CH_COUNT][EXPR_MAX_FILTERS + 1] = { { 0xFF } };  // [0] = 개수 (0xFF = 미기록)
+    uint32_t lastFrameMs = 0;
+  };
+  SlotRender _render[2];
+  uint8_t _cur = 0;               // _render[_cur] = 현재 슬롯, 나머지 = 페이드 중 나가는 슬롯
+  Profile* _profile = nullptr;
+  std::atomic<uint16_t> _profileLeft{0};
+  CRGB*    _fadeFrom = nullptr;   // 나가는 화면 (numLeds개, 컨트롤러가 정적으로 할당)
+  int      _outSlot = 0;          // 페이드 중 계속 그리는 나가는 슬롯 (0 = 보관한 화면 사용)
+  uint32_t _outStart = 0;
+  uint16_t _fadeMs = 0;
+  uint32_t _fadeStart = 0;
+  bool     _fadePending = false;  // 다음 프레임에서 스냅샷 후 페이드 시작
+  bool     _fading = false;
+
+  // 슬롯의 프레임 하나를 leds에 렌더링 (프레임 잠금 안에서 호출)
+  // st: 이 슬롯의 오실레이터/상태 함수, prof: 이 프레임을 계측할지
+  void _renderSlot(CRGB* leds, int slot, uint32_t elapsedMs, SlotRender& st, bool prof) {
+    const Lib& lib = Lib::instance();
 
-  void _loadFromNVS() {
-    for (int i = 1; i <= 5; i++) {
-      String keyPrefix = "p" + String(i) + "_";
-      if (_prefs.isKey((keyPrefix + "valid").c_str())) {
-        _patterns[i].valid = _prefs.getBool((keyPrefix + "valid").c_str());
-        _patterns[i].name = _prefs.getString((keyPrefix + "name").c_str(), "Pattern " + String(i));
-        _patterns[i].hue_expr = _prefs.getString((keyPrefix + "hue").c_str(), "0");
-        _patterns[i].sat_expr = _prefs.getString((keyPrefix + "sat").c_str(), "1");
-        _patterns[i].val_expr = _prefs.getString((keyPrefix + "val").c_str(), "0.5");
+    // Slot 6: Blackout (모두 끄기)
+    // 다른 컨트롤러의 버퍼까지 지우지 않도록 FastLED.clear() 대신 이 버퍼만 채운다.
+    if (slot == Lib::BLACKOUT_SLOT) {
+      for (int i = 0; i < _numLeds; i++) leds[i] = CRGB::Black;
+      return;
+    }
+
+    // Slot 7: 스트리밍 - 수식 엔진을 거치지 않고 최신 프레임만 반영
+    if (slot == Lib::STREAM_SLOT) {
+      // 페이드 중에는 leds가 섞인 화면이므로 새 프레임이 없으면 마지막 프레임을 다시 놓는다
+      if (!_stream.latch(leds, micros()) && _fading) _stream.copyFront(leds);
+      return;
+    }
+
+    // Slot 8~: 네이티브 커널 (이 컨트롤러의 LED 수로 특수화된 구현)
+    if (slot >= Lib::NATIVE_SLOT_BASE) {
+      int k = slot - Lib::NATIVE_SLOT_BASE;
+      _kernels[k].render(leds, elapsedMs, lib.getNativeParams(slot));
+      return;
+    }
+
+    float t = elapsedMs / 1000.0f;
+    const Lib::Pattern& p = *lib.getPattern(slot);
+
+    // 이 슬롯이 다시 저장되면 오실레이터 배치가 바뀔 수 있으므로 초기화
+    // (다른 링의 슬롯 전환이나 set_param은 코드를 바꾸지 않으므로 위상을 유지)
+    // 상태 함수는 배치가 그대로면 유지 (다시 저장해도 값이 튀지 않도록)
+    if (p.codeSerial != st.oscCodeSerial) {
+      _invalidateOscillators(st);
+      st.oscCodeSerial = p.codeSerial;
+      for (int c = 0; c < Lib::CH_COUNT; c++) {
+        const CompiledExpr& e = p.code[c];
+        if (e.filterCount != st.filterLayout[c][0] ||
+            memcmp(e.filters, &st.filterLayout[c][1], e.filterCount) != 0) {
+          _resetFilters(st);
+          break;
+        }
       }
     }
+
+    // InPort 값, 오실레이터, 상태 함수는 프레임당 한 번만 갱신
+    float dt = (elapsedMs - st.lastFrameMs) * 0.001f;
+    st.lastFrameMs = elapsedMs;
+    float inputs[Lib::CH_COUNT][EXPR_MAX_INPUTS];
+    for (int c = 0; c < Lib::CH_COUNT; c++) {
+      ExpressionEvaluator::resolveInputs(p.code[c], inputs[c]);
+      ExpressionEvaluator::advanceOscillators(p.code[c], st.osc[c], elapsedMs);
+      if (p.code[c].filterCount > 0) {
+        ExprContext frame = { 0.0f, t, 0, inputs[c], p.params, st.osc[c], st.filt[c], 0.0f };
+        ExpressionEvaluator::advanceFilters(p.code[c], st.filt[c], frame, dt);
+      }
+    }
+    if (st.filterLayout[0][0] == 0xFF) {
+      for (int c = 0; c < Lib::CH_COUNT; c++) {
+        st.filterLayout[c][0] = p.code[c].filterCount;
+        memcpy(&st.filterLayout[c][1], p.code[c].filters, p.code[c].filterCount);
+      }
+    }
+
+    if (prof) {
+      _renderFormula<true>(leds, p, st, t, inputs);
+      _profile->frames++;
+      _profileLeft--;
+    } else {
+      _renderFormula<false>(leds, p, st, t, inputs);
+    }
   }
 
-  void _saveToNVS(int slot) {
-    String keyPrefix = "p" + String(slot) + "_";
-    _prefs.putBool((keyPrefix + "valid").c_str(), _patterns[slot].valid);
-    _prefs.putString((keyPrefix + "name").c_str(), _patterns[slot].name);
-    _prefs.putString((keyPrefix + "hue").c_str(), _patterns[slot].hue_expr);
-    _prefs.putString((keyPrefix + "sat").c_str(), _patterns[slot].sat_expr);
-    _prefs.putString((keyPrefix + "val").c_str(), _patterns[slot].val_expr);
+  // 나가는 화면(_fadeFrom)과 새 프레임(leds)을 8비트 정수 가중치로 섞는다
+  void _blendFade(CRGB* leds, uint32_t now) {
+    const uint32_t elapsed = now - _fadeStart;
+    if (elapsed >= _fadeMs) {
+      _fading = false;   // 마지막 프레임은 새 패턴 그대로
+      _outSlot = 0;
+      return;
+    }
+    const uint8_t amount = (uint8_t)((elapsed * 256) / _fadeMs);
+    for (uint16_t i = 0; i < _numLeds; i++) leds[i] = blend(_fadeFrom[i], leds[i], amount);
+  }
+
+  template <bool Prof>
+  void _renderFormula(CRGB* leds, const Lib::Pattern& p, SlotRender& st, float t, const float (*inputs)[EXPR_MAX_INPUTS]) {
+    ExprProfile* prof = Prof ? _profile->ch : nullptr;
+    for (int i = 0; i < _numLeds; i++) {
+      float theta = (2.0f * PI * i) / _numLeds;
+
+      ExprContext ctx = { theta, t, i, inputs[Lib::CH_HUE], p.params, st.osc[Lib::CH_HUE], st.filt[Lib::CH_HUE], 0.0f };
+      float h = ExpressionEvaluator::run<Prof>(p.code[Lib::CH_HUE], ctx, prof + Lib::CH_HUE);
+      ctx.inputs = inputs[Lib::CH_SAT];
+      ctx.osc = st.osc[Lib::CH_SAT];
+      ctx.filters = st.filt[Lib::CH_SAT];
+      float s = ExpressionEvaluator::run<Prof>(p.code[Lib::CH_SAT], ctx, prof + Lib::CH_SAT);
+      ctx.inputs = inputs[Lib::CH_VAL];
+      ctx.osc = st.osc[Lib::CH_VAL];
+      ctx.filters = st.filt[Lib::CH_VAL];
+      float v = ExpressionEvaluator::run<Prof>(p.code[Lib::CH_VAL], ctx, prof + Lib::CH_VAL);
+
+      // 정규화 후 HSV → RGB
+      HsvBytes hsv = normalizeHsv(h, s, v);
+      leds[i] = CHSV(hsv.h, hsv.s, hsv.v);
+    }
+  }
+
+  // 재생 시작/중지 (프레임 잠금을 잡은 상태에서 호출)
+  // Slot 1~5: Saved Patterns, Slot 6: Blackout, Slot 7: Stream, Slot 8~: Native
+  // 새 슬롯의 상태(오실레이터/상태 함수 초기화)는 호출한 쪽에서 준비하고, 렌더 태스크는 다음 프레임부터 그린다.
+  // 바이트코드는 저장 시 컴파일되어 있으므로 첫 프레임에 추가 비용이 없다.
+  bool _start(int slot, float duration_sec, uint16_t fadeMs) {
+    if (slot == 0) {
+      _stop();
+      return true;
+    }
+    if (!Lib::instance().isPlayable(slot)) return false;
+
+    _fadeMs = _fadeFrom ? fadeMs : 0;
+    // 재생 중이던 슬롯은 상태를 그대로 넘겨 페이드 동안 계속 그린다
+    // (페이드 도중 다시 전환하면 섞인 화면에서 이어지도록 보관한 화면을 쓴다)
+    if (_fadeMs > 0 && _active && !_fading && !_fadePending) {
+      _outSlot = _current_slot;
+      _outStart = _start_time;
+      _cur ^= 1;
+    } else {
+      _outSlot = 0;
+    }
+
+    _current_slot = slot;
+    _current_duration = duration_sec;
+    _active = true;
+    _start_time = millis();
+    _invalidateOscillators(_render[_cur]);
+    _resetFilters(_render[_cur]);
+    _fadePending = _fadeMs > 0;
+    _fading = false;
+    Lib::instance().touch();
+    return true;
   }
-};
\ No newline at end of file
+
+  // 중지는 즉시 (IDLE 눈 깜빡임은 자체 전환 효과가 있다)
+  void _stop() {
+    _active = false;
+    _current_slot = 0;
+    _outSlot = 0;
+    _fadePending = false;
+    _fading = false;
+    Lib::instance().touch();
+  }
+
+  static void _invalidateOscillators(SlotRender& st) {
+    for (int c = 0; c < Lib::CH_COUNT; c++) ExpressionEvaluator::resetOscillators(st.osc[c]);
+  }
+
+  // 다음 프레임에서 상태 함수를 입력값으로 다시 시작하고 배치를 새로 기록
+  static void _resetFilters(SlotRender& st) {
+    for (int c = 0; c < Lib::CH_COUNT; c++) ExpressionEvaluator::resetFilters(st.filt[c]);
+    st.filterLayout[0][0] = 0xFF;
+    st.lastFrameMs = 0;
+  }
+};
@@ -3,6 +3,56 @@
 #include <ArduinoJson.h>
 #include "tool.h"
 #include "eye_controller.h"
+#include <memory>
+#include <new>
+
+// 툴 파라미터 스키마 (사전 직렬화)
+// describe()가 호출될 때마다 JsonObject 트리를 다시 만들지 않도록 원문 JSON을 보관한다.
+// 한도 숫자는 빌드 설정 매크로에서 문자열로 만들어, 매크로를 바꾸면 설명도 따라 바뀐다.
+#define VIBE_STR_(x) #x
+#define VIBE_STR(x)  VIBE_STR_(x)
+
+namespace vibe_schema {
+static const char kCreatePattern[] =
+  "{\"type\":\"object\",\"properties\":{"
+  "\"slot\":{\"type\":\"integer\",\"description\":\"Slot number to save to (1-5). Slot 0 is reserved.\"},"
+  "\"name\":{\"type\":\"string\",\"description\":\"Name of the pattern (e.g., 'Rainbow', 'Police').\"},"
+  "\"hue\":{\"type\":\"string\",\"description\":\"Expression for color (0~2π color wheel)\"},"
+  "\"saturation\":{\"type\":\"string\",\"description\":\"Expression for saturation (0~1)\"},"
+  "\"brightness\":{\"type\":\"string\",\"description\":\"Expression for brightness (0~1)\"},"
+  "\"params\":{\"type\":\"object\",\"description\":\"Named tunable parameters used in the formulas, name to initial value (max " VIBE_STR(EXPR_MAX_UNIFORMS) "). Change later with set_param.\"}},"
+  "\"required\":[\"slot\",\"name\",\"hue\",\"saturation\",\"brightness\"]}";
+
+static const char kChangeSlot[] =
+  "{\"type\":\"object\",\"properties\":{"
+  "\"slot\":{\"type\":\"integer\",\"description\":\"Target slot number (0-11).\"},"
+  "\"duration\":{\"type\":\"number\",\"description\":\"Duration in seconds. 0 = Infinite loop (until changed).\"},"
+  "\"fade\":{\"type\":\"number\",\"description\":\"Crossfade from the current display in seconds (0-10, default 0.25, 0 = instant).\"},"
+  "\"target\":{\"type\":\"string\",\"description\":\"LED ring name from slot_status (default: main ring, 'all' = every ring).\"},"
+  "\"params\":{\"type\":\"object\",\"description\":\"Native pattern parameters (slots 8-11), name to number. See slot_status for names.\"}},"
+  "\"required\":[\"slot\"]}";
+
+static const char kPushFrame[] =
+  "{\"type\":\"object\",\"properties\":{"
+  "\"rgb\":{\"type\":\"string\",\"description\":\"Base64 of packed RGB bytes, 3 per LED in index order (exactly leds*3 bytes of the target ring). Whitespace and line breaks are ignored.\"},"
+  "\"target\":{\"type\":\"string\",\"description\":\"LED ring name from slot_status (default: main ring).\"}},"
+  "\"required\":[\"rgb\"]}";
+
+static const char kSetParam[] =
+  "{\"type\":\"object\",\"properties\":{"
+  "\"slot\":{\"type\":\"integer\",\"description\":\"Pattern slot (1-5) or native slot (8-11).\"},"
+  "\"params\":{\"type\":\"object\",\"description\":\"Parameter name to new value, e.g. {\\\"speed\\\": 3}.\"},"
+  "\"persist\":{\"type\":\"boolean\",\"description\":\"Also save the values to flash (default false).\"}},"
+  "\"required\":[\"slot\",\"params\"]}";
+
+static const char kProfilePattern[] =
+  "{\"type\":\"object\",\"properties\":{"
+  "\"frames\":{\"type\":\"integer\",\"description\":\"Number of frames to sample (1-600, default 60).\"},"
+  "\"top\":{\"type\":\"integer\",\"description\":\"Number of hot subexpressions to return (1-8, default 5).\"},"
+  "\"target\":{\"type\":\"string\",\"description\":\"LED ring name from slot_status (default: main ring).\"}}}";
+
+static const char kNoParams[] = "{\"type\":\"object\"}";
+} // namespace vibe_schema
 
 // 1. 패턴 생성(저장) 툴
 class CreatePatternTool : public ITool {
@@ -19,43 +69,22 @@ public:
     tool["description"] = "Create and save a LED pattern to a persistent slot (1-5). "
                           "The pattern is defined by mathematical expressions for Hue, Saturation, and Brightness. "
                           "Variables: theta (0~2pi), t (time in seconds), i (LED index 0~11), pi, var_a, var_b, var_c. "
-                          "Operators: +, -, *, /, %, <, >, <=, >=, ==, !=, &&, ||, !. "
-                          "Functions: sin, cos, tan, abs, sqrt, floor, ceil, max(a,b), min(a,b), mod(a,b), pow(a,b). "
+                          "Operators: +, -, *, /, %, <, >, <=, >=, ==, !=, &&, ||, !, c ? a : b (only the chosen branch runs). "
+                          "Functions: sin, cos, tan, abs, sqrt, floor, ceil, max(a,b), min(a,b), mod(a,b), pow(a,b), if(c,a,b), "
+                          "noise1(x), noise2(x,y), noise3(x,y,z) (smooth gradient noise, about -1~1, lattice spacing 1; "
+                          "one noise call is cheaper than a stack of sin terms for organic motion). "
+                          "Stateful (once per frame, arguments must not use theta or i): smooth(x,tau), "
+                          "envelope(x,attack,release), peak(x,decay), deriv(x); times in seconds, for smoothing noisy inputs. "
+                          "Formulas are compiled on save; syntax errors or nesting deeper than " VIBE_STR(EXPR_MAX_DEPTH) " levels are rejected. "
+                          "Optional params declares named tunable values (e.g. {\"speed\": 2}) usable in the formulas; "
+                          "change them later with set_param instead of re-creating the pattern. "
                           "Examples: "
-                          "1. Police: hue=(sin(t*10)>0)*0+(sin(t*10)<=0)*4.2, sat=1, val=1 "
+                          "1. Police: hue=sin(t*10)>0 ? 0 : 4.2, sat=1, val=1 "
                           "2. Comet: hue=t*0.5, sat=1, val=max(0,1-abs(mod(theta-t*5,2*pi))) "
-                          "3. Pulse: hue=3.0, sat=1, val=(sin(t*2)+1)/2*var_a (var_a is audio)";
+                          "3. Pulse: hue=3.0, sat=1, val=(sin(t*2)+1)/2*envelope(var_a,0.02,0.3) (var_a is audio)";
     
-    auto params = tool["parameters"].to<JsonObject>();
-    params["type"] = "object";
-    auto props = params["properties"].to<JsonObject>();
-
-    auto slot = props["slot"].to<JsonObject>();
-    slot["type"] = "integer";
-    slot["description"] = "Slot number to save to (1-5). Slot 0 is reserved.";
-
-    auto pname = props["name"].to<JsonObject>();
-    pname["type"] = "string";
-    pname["description"] = "Name of the pattern (e.g., 'Rainbow', 'Police').";
-
-    auto hue = props["hue"].to<JsonObject>();
-    hue["type"] = "string";
-    hue["description"] = "Expression for color (0~2π color wheel)";
-
-    auto sat = props["saturation"].to<JsonObject>();
-    sat["type"] = "string";
-    sat["description"] = "Expression for saturation (0~1)";
-
-    auto val = props["brightness"].to<JsonObject>();
-    val["type"] = "string";
-    val["description"] = "Expression for brightness (0~1)";
-
-    auto req = params["required"].to<JsonArray>();
-    req.add("slot");
-    req.add("name");
-    req.add("hue");
-    req.add("saturation");
-    req.add("brightness");
+    // 스키마는 한 번 직렬화된 정적 문자열을 그대로 붙인다 (힙 트리 생성 없음)
+    tool["parameters"] = serialized(vibe_schema::kCreatePattern);
   }
 
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
@@ -71,12 +100,25 @@ public:
       return false;
     }
 
-    bool success = EyeController::instance().dynamicPattern.savePattern(
-      slot, pname, hue, sat, val
+    // 이름 있는 파라미터 (선택)
+    const char* paramNames[EXPR_MAX_UNIFORMS + 1];
+    float paramValues[EXPR_MAX_UNIFORMS + 1];
+    uint8_t paramCount = 0;
+    PatternLibrary::ToolLock lock(PatternLibrary::instance().toolMutex());  // lastError까지 한 호출로
+    for (JsonPairConst kv : args["params"].as<JsonObjectConst>()) {
+      if (paramCount > EXPR_MAX_UNIFORMS) break; // 초과분은 savePattern이 거부
+      paramNames[paramCount] = kv.key().c_str();
+      paramValues[paramCount] = kv.value().as<float>();
+      paramCount++;
+    }
+
+    bool success = PatternLibrary::instance().savePattern(
+      slot, pname, hue, sat, val, paramNames, paramValues, paramCount
     );
 
     if (!success) {
-      out.error("Failed to save", "Failed to save pattern to slot");
+      // 컴파일 오류 (문법, 중첩 깊이/스택 초과)
+      out.error("Failed to save", PatternLibrary::instance().lastError());
       return false;
     }
 
@@ -108,38 +150,66 @@ public:
                           "Slot 0: Stop pattern and return to IDLE (Blinking). "
                           "Slots 1-5: Execute persistent pattern. "
                           "Slot 6: Blackout (Turn off all LEDs). "
+                          "Slot 7: Stream (Display raw frames sent with push_frame). "
+                          "Slots 8-11: Built-in native patterns (8 rainbow, 9 comet, 10 police, 11 pulse); "
+                          "tune them with the optional params object, e.g. {\"speed\": 2}. "
                           "Duration > 0: Auto-return to IDLE after time. "
-                          "Duration = 0: Loop forever (Default).";
+                          "Duration = 0: Loop forever (Default). "
+                          "fade crossfades from what is currently shown (default 0.25 s; slot 0 switches instantly). "
+                          "target selects the LED ring (see slot_status); 'all' changes every ring.";
     
-    auto params = tool["parameters"].to<JsonObject>();
-    params["type"] = "object";
-    auto props = params["properties"].to<JsonObject>();
-
-    auto slot = props["slot"].to<JsonObject>();
-    slot["type"] = "integer";
-    slot["description"] = "Target slot number (0-5).";
-
-    auto dur = props["duration"].to<JsonObject>();
-    dur["type"] = "number";
-    dur["description"] = "Duration in seconds. 0 = Infinite loop (until changed).";
-
-    auto req = params["required"].to<JsonArray>();
-    req.add("slot");
+    tool["parameters"] = serialized(vibe_schema::kChangeSlot);
   }
 
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
     int slot = args["slot"] | 0;
     float duration = args["duration"] | 0.0f; // Default infinite
+    float fade = args["fade"] | (PATTERN_FADE_MS / 1000.0f);
+    uint16_t fadeMs = (uint16_t)(constrain(fade, 0.0f, 10.0f) * 1000.0f);
+    const char* target = args["target"] | "";
+    auto& lib = PatternLibrary::instance();
+    PatternLibrary::ToolLock lock(lib.toolMutex());
 
-    bool success = EyeController::instance().dynamicPattern.executePattern(slot, duration);
-
-    if (!success) {
+    // 대상 링 (기본 링, 이름, 또는 all)
+    const bool all = (strcmp(target, "all") == 0);
+    EyeController* eye = all ? nullptr : EyeController::find(target);
+    if (!all && !eye) {
+      out.error("Change failed", "Unknown target ring");
+      return false;
+    }
+    if (!lib.isPlayable(slot) && slot != 0) {
       out.error("Change failed", "Invalid slot or empty pattern slot");
       return false;
     }
 
+    // 네이티브 패턴 파라미터 (선택, 모든 링 공통)
+    JsonObjectConst params = args["params"].as<JsonObjectConst>();
+    if (!params.isNull()) {
+      if (!lib.getNativeKernel(slot)) {
+        out.error("Change failed", "params are only supported for native slots (8-11)");
+        return false;
+      }
+      // 모든 이름을 먼저 확인한 뒤 적용 (실패한 호출이 일부 파라미터만 바꿔 두지 않도록)
+      for (JsonPairConst kv : params) {
+        if (PatternLibrary::nativeParamIndex(slot, kv.key().c_str()) < 0) {
+          out.error("Change failed", "Unknown parameter for this native pattern");
+          return false;
+        }
+      }
+      for (JsonPairConst kv : params) lib.setNativeParam(slot, kv.key().c_str(), kv.value().as<float>());
+    }
+
+    if (all) {
+      for (uint8_t i = 0; i < EyeController::count(); i++) {
+        EyeController::at(i)->dynamicPattern.executePattern(slot, duration, fadeMs);
+      }
+    } else {
+      eye->dynamicPattern.executePattern(slot, duration, fadeMs);
+    }
+
     JsonDocument doc;
     doc["slot"] = slot;
+    doc["target"] = all ? "all" : eye->name();
     doc["state"] = (slot == 0) ? "IDLE (Blinking)" : "PATTERN_ACTIVE";
     doc["duration"] = (duration > 0) ? String(duration) + "s" : "Infinite";
     
@@ -162,20 +232,60 @@ public:
 
   void describe(JsonObject& tool) override {
     tool["name"] = name();
-    tool["description"] = "Check the status of all pattern slots (1-5). "
-                          "Returns name, formulas, valid status, and active status for each slot.";
-    tool["parameters"]["type"] = "object"; // No params needed
+    tool["description"] = "Check the status of all pattern slots (1-5) and LED rings. "
+                          "Returns name, formulas, valid status, and active status (on the main ring) for each slot, "
+                          "plus each ring's name, LED count and active slot.";
+    tool["parameters"] = serialized(vibe_schema::kNoParams); // No params needed
   }
 
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
-    auto& dp = EyeController::instance().dynamicPattern;
-    int maxSlots = dp.getMaxSlots(); // 5
+    (void)args;
+    auto& lib = PatternLibrary::instance();
+    PatternLibrary::ToolLock lock(lib.toolMutex());  // 캐시와 패턴 문자열 보호
+
+    // 슬롯 테이블/활성 슬롯이 그대로면 직전 응답을 재사용
+    uint32_t rev = lib.revision();
+    if (!_cacheValid || rev != _cacheRev) {
+      _rebuild(lib);
+      _cacheRev = rev;
+      _cacheValid = true;
+    }
+
+    // 렌더 스택 여유는 리비전과 무관하게 변하므로 캐시 밖에서 매번 새로 읽어 앞에 붙인다
+    char head[40];
+    snprintf(head, sizeof(head), "{\"render_stack_free\":%u,", (unsigned)EyeController::stackHighWaterMark()); // bytes
+    _reply = head;
+    _reply += _payload.c_str() + 1;  // 캐시된 객체의 '{' 다음부터
+    out.success(_reply.c_str());
+    return true;
+  }
+
+private:
+  String   _payload;   // render_stack_free를 뺀 응답 (리비전 캐시)
+  String   _reply;     // 호출마다 조립하는 최종 응답 (버퍼 재사용)
+  uint32_t _cacheRev = 0;
+  bool     _cacheValid = false;
+
+  void _rebuild(const PatternLibrary& lib) {
+    int maxSlots = lib.getMaxSlots(); // 5
+    int current = EyeController::instance().dynamicPattern.getCurrentSlot();
 
     JsonDocument doc;
+    doc["active_slot"] = current; // 0 = IDLE (Blinking), 기본 링 기준
+
+    // LED 링 목록 (change_slot / push_frame의 target)
+    auto rings = doc["controllers"].to<JsonArray>();
+    for (uint8_t i = 0; i < EyeController::count(); i++) {
+      EyeController* eye = EyeController::at(i);
+      auto obj = rings.add<JsonObject>();
+      obj["name"] = eye->name();
+      obj["leds"] = eye->numLeds();
+      obj["active_slot"] = eye->dynamicPattern.getCurrentSlot();
+    }
     auto patterns = doc["slots"].to<JsonArray>();
 
     for (int i = 1; i <= maxSlots; i++) {
-      const auto* p = dp.getPattern(i);
+      const auto* p = lib.getPattern(i);
       auto obj = patterns.add<JsonObject>();
       obj["slot"] = i;
       
@@ -184,28 +294,327 @@ public:
         obj["is_empty"] = false;
         obj["hue"] = p->hue_expr;
         // Simplified output for readability, can add others if needed
+        obj["eval_stack"] = p->evalStack(); // 값 스택 요구량 (float 개수)
+        obj["depth"] = p->depth();
+        if (p->paramCount > 0) {
+          auto params = obj["params"].to<JsonObject>();
+          for (uint8_t k = 0; k < p->paramCount; k++) params[p->paramNames[k]] = p->params[k];
+        }
+      } else if (p && p->loadError[0]) {
+        // 저장돼 있지만 현재 수식 규칙으로 컴파일되지 않아 부팅 시 비활성화된 슬롯
+        obj["name"] = p->name;
+        obj["is_empty"] = false;
+        obj["disabled"] = true;
+        obj["load_error"] = (const char*)p->loadError;
+        obj["hue"] = p->hue_expr;
       } else {
-        obj["name"] = "Empty";
-        obj["is_empty"] = true;
+        obj["name"] = (i == 6) ? "Blackout" : "Empty";
+        obj["is_empty"] = (i != 6);
       }
-      
-      // Active Status check (This part requires access to private _current_slot or public getter)
-      // Since we don't have a direct public getter for current slot in the snippet above...
-      // Let's assume user just wants list. Or we can add IS_ACTIVE check if the pattern matches current.
-      // Ideally DynamicPattern should expose current slot index. 
-      // Checking implementation... DynamicPattern has no public `getCurrentSlot`. 
-      // However, `isActive()` tells if ANY pattern is running.
-      // Let's stick to listing for now, or add a getter if strictly required. 
-      // Actually the plan said "is_active". I should check if I can implement it.
-      // I can add `getCurrentSlot()` to DynamicPattern later or just omit for now to be safe.
-      // Let's omit `is_active` per slot for now to avoid compilation error, or just imply it from logs.
-      // Wait, I can modify DynamicPattern to add `getCurrentSlot()`? I already modified it.
-      // Let's stick to what's available. `p` is pointer.
+      obj["is_active"] = (i == current);
+    }
+
+    // 네이티브 커널 슬롯 (항상 사용 가능)
+    auto natives = doc["native"].to<JsonArray>();
+    for (int slot = PatternLibrary::NATIVE_SLOT_BASE; slot <= PatternLibrary::LAST_SLOT; slot++) {
+      const NativeKernelInfo* info = lib.getNativeKernel(slot);
+      const float* values = lib.getNativeParams(slot);
+      auto obj = natives.add<JsonObject>();
+      obj["slot"] = slot;
+      obj["name"] = info->name;
+      obj["is_active"] = (slot == current);
+      auto params = obj["params"].to<JsonObject>();
+      for (int p = 0; p < info->paramCount; p++) params[info->paramNames[p]] = values[p];
+    }
+
+    _payload = "";
+    serializeJson(doc, _payload);
+  }
+};
+
+// 4. 파라미터 변경 툴 (Set Param)
+// 수식 파싱/컴파일이나 NVS 쓰기 없이 RAM 값만 바꾼다. persist=true일 때만 슬롯당 키 하나를 저장.
+class SetParamTool : public ITool {
+public:
+  bool init() override {
+    EyeController::instance().begin();
+    return true;
+  }
+
+  const char* name() const override { return "set_param"; }
+
+  void describe(JsonObject& tool) override {
+    tool["name"] = name();
+    tool["description"] = "Change named parameters of a saved pattern (slots 1-5, declared with create_pattern params) "
+                          "or a native pattern (slots 8-11) without re-sending formulas. "
+                          "Takes effect on the next frame. Set persist=true to keep the values after reboot. "
+                          "Parameter names are listed in slot_status.";
+    tool["parameters"] = serialized(vibe_schema::kSetParam);
+  }
+
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    int slot = args["slot"] | -1;
+    bool persist = args["persist"] | false;
+    auto& lib = PatternLibrary::instance();
+    PatternLibrary::ToolLock lock(lib.toolMutex());  // lastError까지 한 호출로
+
+    JsonObjectConst params = args["params"].as<JsonObjectConst>();
+    if (params.isNull()) {
+      out.error("Set failed", "params object is required");
+      return false;
+    }
+    // 모든 이름을 먼저 확인한 뒤 적용 (실패한 호출이 일부 파라미터만 바꿔 두지 않도록)
+    for (JsonPairConst kv : params) {
+      if (!lib.hasParam(slot, kv.key().c_str())) {
+        out.error("Set failed", lib.lastError());
+        return false;
+      }
+    }
+    for (JsonPairConst kv : params) lib.setParam(slot, kv.key().c_str(), kv.value().as<float>());
+    if (persist && !lib.persistParams(slot)) {
+      out.error("Set failed", "Could not save parameters");
+      return false;
+    }
+
+    char payload[64];
+    snprintf(payload, sizeof(payload), "{\"slot\":%d,\"updated\":%u,\"persisted\":%s}",
+             slot, (unsigned)params.size(), persist ? "true" : "false");
+    out.success(payload);
+    return true;
+  }
+};
+
+// 5. 원시 프레임 전송 툴 (Push Frame)
+// Slot 7(Stream) 활성 시 다음 프레임에 표시된다. 응답은 JsonDocument 없이 고정 버퍼로 만든다.
+class PushFrameTool : public ITool {
+public:
+  bool init() override {
+    EyeController::instance().begin();
+    return true;
+  }
+
+  const char* name() const override { return "push_frame"; }
+
+  void describe(JsonObject& tool) override {
+    tool["name"] = name();
+    tool["description"] = "Send one raw RGB frame for Slot 7 (Stream mode), bypassing the expression engine. "
+                          "Only the latest frame is shown; frames replaced before display are counted as dropped. "
+                          "Call change_slot(7) to display the stream. "
+                          "target selects the LED ring (see slot_status); each ring has its own stream. "
+                          "Returns counters and receive-to-display latency in microseconds.";
+    tool["parameters"] = serialized(vibe_schema::kPushFrame);
+  }
+
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    const uint32_t recvUs = micros();
+    EyeController* eye = EyeController::find(args["target"] | "");
+    if (!eye) {
+      out.error("Invalid frame", "Unknown target ring");
+      return false;
+    }
+    auto& dp = eye->dynamicPattern;
+    FrameStream& fs = dp.frameStream();
+
+    if (!fs.pushBase64(args["rgb"] | "", recvUs)) {
+      out.error("Invalid frame", "rgb must be base64 of exactly leds*3 bytes of the target ring");
+      return false;
+    }
+
+    const FrameStream::Stats& st = fs.stats();
+    char payload[200];
+    snprintf(payload, sizeof(payload),
+             "{\"streaming\":%s,\"received\":%lu,\"shown\":%lu,\"dropped\":%lu,\"invalid\":%lu,"
+             "\"latency_us\":{\"last\":%lu,\"avg\":%lu,\"max\":%lu}}",
+             dp.isStreaming() ? "true" : "false",
+             (unsigned long)st.received, (unsigned long)st.shown,
+             (unsigned long)st.dropped, (unsigned long)st.invalid,
+             (unsigned long)st.lastLatencyUs, (unsigned long)st.avgLatencyUs,
+             (unsigned long)st.maxLatencyUs);
+    out.success(payload);
+    return true;
+  }
+};
+
+// 6. 수식 프로파일 툴 (Profile Pattern)
+// 재생 중인 수식 슬롯을 N 프레임 동안 명령 단위로 계측하고, 비용이 큰 부분식을 원문 위치와 함께 돌려준다.
+// 계측은 arm된 프레임에서만 켜지고 나머지 프레임은 계측 코드 없이 실행된다.
+class ProfilePatternTool : public ITool {
+public:
+  bool init() override {
+    EyeController::instance().begin();
+    return true;
+  }
+
+  const char* name() const override { return "profile_pattern"; }
+
+  void describe(JsonObject& tool) override {
+    tool["name"] = name();
+    tool["description"] = "Profile the formula pattern (slots 1-5) currently playing on a ring. "
+                          "Samples the given number of frames and returns the most expensive subexpressions "
+                          "as source text with [start, end) positions, self/inclusive share of the total cost and "
+                          "execution counts. Use it to find which part of a formula to simplify. "
+                          "Absolute numbers include measurement overhead; compare the percentages.";
+    tool["parameters"] = serialized(vibe_schema::kProfilePattern);
+  }
+
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    EyeController* eye = EyeController::find(args["target"] | "");
+    if (!eye) {
+      out.error("Profile failed", "Unknown target ring");
+      return false;
+    }
+    int frames = constrain((int)(args["frames"] | 60), 1, 600);
+    int top = constrain((int)(args["top"] | 5), 1, MAX_TOP);
+
+    // 렌더 태스크가 프로파일을 하나만 받으므로 동시에 한 번만 (대기 중에도 다른 툴은 막지 않는다)
+    std::unique_lock<std::mutex> busy(_busy, std::try_to_lock);
+    if (!busy.owns_lock()) {
+      out.error("Profile failed", "Another profile is already running");
+      return false;
+    }
+
+    // 계측 버퍼(수 KB)는 이 호출 동안만 힙에 둔다
+    std::unique_ptr<Work> work(new (std::nothrow) Work);
+    if (!work) {
+      out.error("Profile failed", "Out of memory for profile buffers");
+      return false;
+    }
+
+    auto& dp = eye->dynamicPattern;
+    auto& lib = PatternLibrary::instance();
+    int slot = dp.getCurrentSlot();
+    bool playable = false;
+    if (slot >= 1 && slot <= lib.getMaxSlots()) {
+      PatternLibrary::ToolLock lock(lib.toolMutex());
+      playable = lib.isPlayable(slot);
+    }
+    if (!playable) {
+      out.error("Profile failed", "Target ring is not playing a formula slot (1-5)");
+      return false;
+    }
+
+    // 렌더 태스크가 계측을 마칠 때까지 대기 (느려진 프레임을 감안해 여유를 둔다)
+    dp.armProfile(&work->prof, (uint16_t)frames);
+    uint32_t start = millis();
+    uint32_t limit = (uint32_t)frames * eye->cfg.tickMs * 2 + 500;
+    while (!dp.profileDone()) {
+      if (dp.getCurrentSlot() != slot || millis() - start > limit) {
+        dp.cancelProfile();
+        out.error("Profile failed", "Pattern stopped or changed before sampling finished");
+        return false;
+      }
+      delay(5);
+    }
+
+    PatternLibrary::ToolLock lock(lib.toolMutex());  // 원문 위치 확인부터 응답까지 패턴이 바뀌지 않도록
+    for (int c = 0; c < PatternLibrary::CH_COUNT; c++) {
+      if (!lib.sourceSpans(slot, (PatternLibrary::Channel)c, work->spans[c])) {
+        out.error("Profile failed", "Pattern was modified during profiling");
+        return false;
+      }
+    }
+    _report(lib, slot, *work, eye->numLeds(), top, out);
+    return true;
+  }
+
+private:
+  static constexpr int MAX_TOP = 8;
+
+  struct Hot {
+    uint8_t  ch, pc;
+    uint32_t self, incl;
+  };
+
+  // 호출 한 번의 계측 결과와 명령별 원문 위치
+  struct Work {
+    DynamicPattern::Profile prof;
+    ExprSpan spans[PatternLibrary::CH_COUNT][EXPR_MAX_CODE];
+  };
+
+  std::mutex _busy;
+
+  void _report(const PatternLibrary& lib, int slot, const Work& work, uint16_t leds, int top, ObservationBuilder& out) {
+    const DynamicPattern::Profile& prof = work.prof;
+    static const char* const kChannelNames[PatternLibrary::CH_COUNT] = { "hue", "saturation", "brightness" };
+    const PatternLibrary::Pattern* p = lib.getPattern(slot);
+
+    uint64_t total = 0;
+    uint64_t perCh[PatternLibrary::CH_COUNT] = {};
+    for (int c = 0; c < PatternLibrary::CH_COUNT; c++) {
+      for (int pc = 0; pc < p->code[c].codeLen; pc++) perCh[c] += prof.ch[c].cycles[pc];
+      total += perCh[c];
+    }
+    if (total == 0) total = 1;
+
+    // 같은 원문 구간에서 나온 명령을 한 노드로 묶는다. 노드의 마지막 명령(후위 순서상 자기 연산)이 대표.
+    Hot hot[MAX_TOP];
+    int hotCount = 0;
+    for (int c = 0; c < PatternLibrary::CH_COUNT; c++) {
+      const ExprSpan* sp = work.spans[c];
+      int len = p->code[c].codeLen;
+      for (int pc = 0; pc < len; pc++) {
+        bool last = true;
+        for (int k = pc + 1; k < len && last; k++) {
+          if (sp[k].start == sp[pc].start && sp[k].end == sp[pc].end) last = false;
+        }
+        if (!last) continue;
+
+        Hot h = { (uint8_t)c, (uint8_t)pc, 0, 0 };
+        for (int k = 0; k < len; k++) {
+          uint32_t cyc = prof.ch[c].cycles[k];
+          if (sp[k].start >= sp[pc].start && sp[k].end <= sp[pc].end) h.incl += cyc;
+          if (sp[k].start == sp[pc].start && sp[k].end == sp[pc].end) h.self += cyc;
+        }
+        if (h.self == 0) continue;
+
+        // self 비용 내림차순 삽입
+        int at = hotCount;
+        while (at > 0 && hot[at - 1].self < h.self) at--;
+        if (at >= top) continue;
+        if (hotCount < top) hotCount++;
+        for (int k = hotCount - 1; k > at; k--) hot[k] = hot[k - 1];
+        hot[at] = h;
+      }
+    }
+
+    JsonDocument doc;
+    doc["slot"] = slot;
+    doc["name"] = p->name;
+    doc["frames"] = prof.frames;
+    doc["leds"] = leds;
+    doc["unit"] = EXPR_CYCLE_UNIT;
+    doc["total"] = total;
+    doc["per_frame"] = (uint32_t)(total / (prof.frames ? prof.frames : 1));
+    auto share = doc["channels"].to<JsonObject>();
+    for (int c = 0; c < PatternLibrary::CH_COUNT; c++) {
+      share[kChannelNames[c]] = _pct(perCh[c], total);
+    }
+
+    auto list = doc["hot"].to<JsonArray>();
+    for (int k = 0; k < hotCount; k++) {
+      const Hot& h = hot[k];
+      const String& src = (h.ch == PatternLibrary::CH_HUE) ? p->hue_expr
+                        : (h.ch == PatternLibrary::CH_SAT) ? p->sat_expr : p->val_expr;
+      const ExprSpan& sp = work.spans[h.ch][h.pc];
+      auto obj = list.add<JsonObject>();
+      obj["channel"] = kChannelNames[h.ch];
+      obj["expr"] = src.substring(sp.start, sp.end);
+      auto range = obj["at"].to<JsonArray>();
+      range.add(sp.start);
+      range.add(sp.end);
+      obj["op"] = ExpressionEvaluator::opName(p->code[h.ch].code[h.pc].op);
+      obj["self_pct"] = _pct(h.self, total);
+      obj["incl_pct"] = _pct(h.incl, total);
+      obj["execs"] = prof.ch[h.ch].count[h.pc];
     }
 
     String payload;
     serializeJson(doc, payload);
     out.success(payload.c_str());
-    return true;
   }
-};
\ No newline at end of file
+
+  // 소수점 한 자리 백분율
+  static float _pct(uint64_t part, uint64_t total) {
+    return (float)((part * 1000 + total / 2) / total) / 10.0f;
+  }
+};
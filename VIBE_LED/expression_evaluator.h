@@ -0,0 +1,1234 @@
+#pragma once
+// 패턴 수식 엔진 (플랫폼 독립)
+// Arduino/FastLED 의존성이 없으므로 호스트(Linux) 도구에서도 같은 코드를 사용한다.
+//
+// 수식은 저장 시점에 한 번 바이트코드로 컴파일되고, 렌더링 중에는
+// 고정 크기 값 스택을 쓰는 비재귀 루프로 실행된다.
+//   - 파서: 명시적 스택을 쓰는 Shunting-yard (재귀 없음)
+//   - 중첩 깊이/스택 요구량은 컴파일 시 검사하여 초과하면 저장 거부
+//   - 조건식(c ? a : b, if(c,a,b))과 &&/||는 점프로 컴파일되어 죽은 분기를 실행하지 않는다
+//   - sin/cos(a*t + b) 꼴(a는 상수)은 오실레이터로 바꿔, 정수 ms 시간축의 위상 누산기와
+//     회전 점화식으로 프레임마다 갱신한다 (긴 가동 시간에도 float t 정밀도 손실 없음)
+//   - noise1/2/3은 정수 그래디언트 노이즈 커널(gradient_noise.h)을 한 번 호출한다
+//   - 상태 함수(smooth/envelope/peak/deriv)는 인자와 함께 프레임 전처리 구간으로 옮겨
+//     프레임마다 한 번만 갱신하고, LED 루프에서는 결과 값만 읽는다
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "gradient_noise.h"
+
+#define VIBE_PI 3.14159265358979f
+
+#ifndef EXPR_MAX_CODE
+#define EXPR_MAX_CODE    96   // 수식당 최대 명령 수
+#endif
+#ifndef EXPR_MAX_CONSTS
+#define EXPR_MAX_CONSTS  24   // 수식당 최대 상수 수
+#endif
+#ifndef EXPR_MAX_INPUTS
+#define EXPR_MAX_INPUTS  4    // 수식당 최대 InPort 변수 수
+#endif
+#ifndef EXPR_MAX_UNIFORMS
+#define EXPR_MAX_UNIFORMS 4   // 패턴당 최대 이름 있는 파라미터 수
+#endif
+#ifndef EXPR_MAX_OSC
+#define EXPR_MAX_OSC     4    // 수식당 최대 오실레이터 수
+#endif
+#ifndef EXPR_OSC_RESYNC
+#define EXPR_OSC_RESYNC  64   // 회전 점화식을 이 프레임 수마다 정확한 위상으로 재동기화
+#endif
+#ifndef EXPR_MAX_FILTERS
+#define EXPR_MAX_FILTERS 4    // 수식당 최대 상태 함수(smooth/envelope/peak/deriv) 수
+#endif
+#define EXPR_OSC_MAX_RATE 3000.0f // rad/s, 이보다 빠르면 일반 sin/cos로 계산
+// 프로파일러 시간 카운터 (ESP32: CPU 사이클, 호스트: ns)
+#ifndef EXPR_CYCLE_COUNT
+  #if defined(ESP32)
+    #include <Arduino.h>
+    #define EXPR_CYCLE_COUNT() ((uint32_t)ESP.getCycleCount())
+    #define EXPR_CYCLE_UNIT "cycles"
+  #else
+    #include <chrono>
+    #define EXPR_CYCLE_COUNT() ((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>( \
+        std::chrono::steady_clock::now().time_since_epoch()).count())
+    #define EXPR_CYCLE_UNIT "ns"
+  #endif
+#endif
+#ifndef EXPR_CYCLE_UNIT
+#define EXPR_CYCLE_UNIT "ticks"
+#endif
+#ifndef EXPR_STACK_SIZE
+#define EXPR_STACK_SIZE  16   // 실행 값 스택 (정적 상한)
+#endif
+#ifndef EXPR_MAX_DEPTH
+#define EXPR_MAX_DEPTH   16   // 최대 중첩 깊이 (괄호/단항/함수 포함 트리 깊이)
+#endif
+#define EXPR_MAX_NODES   EXPR_MAX_CODE
+#define EXPR_NAME_LEN    16
+
+// ★ 전방 선언 (순환 include 방지)
+extern float port_get_inport_value(const char* name);
+
+enum ExprOp : uint8_t {
+  // 피연산자
+  OP_CONST, OP_THETA, OP_T, OP_I, OP_INPUT, OP_UNIFORM,
+  OP_PHASE,                  // (a*t) mod 2π, 오실레이터 위상
+  OP_OSC_SIN, OP_OSC_COS,    // sin/cos(a*t + b), 프레임당 한 번 갱신된 값
+  OP_FILTER,                 // 상태 함수 결과 (arg = 상태 인덱스, 프레임 전처리가 갱신)
+  // 단항
+  OP_NEG, OP_NOT,
+  // 이항
+  OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+  OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,
+  OP_AND, OP_OR,
+  // 함수
+  OP_SIN, OP_COS, OP_TAN, OP_ABS, OP_SQRT, OP_FLOOR, OP_CEIL,
+  OP_MAX, OP_MIN, OP_FMOD, OP_POW,
+  OP_NOISE1, OP_NOISE2, OP_NOISE3,
+  // 조건 (구문 트리 전용, 점프로 컴파일됨)
+  OP_SELECT,
+  // 상태 함수 (구문 트리 전용, 프레임 전처리의 OP_FILTER_STEP + OP_FILTER로 컴파일됨)
+  OP_SMOOTH, OP_ENVELOPE, OP_PEAK, OP_DERIV,
+  // 제어 (arg = 점프할 pc)
+  OP_JMP,         // 무조건 점프
+  OP_JZ,          // pop, 0이면 점프
+  OP_JZ_KEEP,     // &&: 0이면 0을 남기고 점프, 아니면 pop
+  OP_JNZ_KEEP,    // ||: 0이 아니면 1을 남기고 점프, 아니면 pop
+  OP_BOOL,        // 0이 아니면 1
+  // 프레임 전처리 (arg = 상태 인덱스): 인자를 pop해 상태 함수 갱신
+  OP_FILTER_STEP,
+  OP_COUNT
+};
+
+struct ExprInstr {
+  uint8_t op;
+  uint8_t arg;   // 상수/InPort/파라미터 인덱스, 점프 명령(OP_JMP/OP_JZ 등)의 대상 위치
+};
+static_assert(EXPR_MAX_CODE <= 255, "EXPR_MAX_CODE must fit ExprInstr::arg (uint8_t jump targets)");
+static_assert(EXPR_MAX_CONSTS <= 256, "EXPR_MAX_CONSTS must fit ExprInstr::arg (uint8_t index)");
+
+// 오실레이터 정의: 위상 = rate * t + offset
+struct ExprOsc {
+  float    rate;      // rad/s
+  float    offset;    // rad
+  uint64_t stepQ64;   // ms당 위상 증가량 (Q64 회전수, 음수는 2의 보수)
+  bool     rotate;    // sin/cos 값을 점화식으로 유지 (OP_OSC_SIN/COS에서 사용)
+};
+
+// 오실레이터 실행 상태 (재생 중인 패턴마다, advanceOscillators()가 프레임당 한 번 갱신)
+struct ExprOscState {
+  float    phase;     // (rate * t) mod 2π, offset 제외
+  float    s, c;      // sin/cos(phase + offset)
+  uint32_t lastMs;
+  float    rotC[2], rotS[2];   // 프레임 간격(dt)별 회전 캐시
+  uint16_t rotDt[2];
+  uint8_t  rotNext;
+  uint8_t  sinceSync;
+  bool     valid;     // false면 다음 프레임에 정확한 값으로 초기화
+};
+
+// 상태 함수 실행 상태 (재생 중인 패턴마다, advanceFilters()가 프레임당 한 번 갱신)
+struct ExprFilterState {
+  float y;        // 결과 값
+  float prev;     // 직전 프레임 입력 (deriv)
+  bool  valid;    // false면 다음 프레임 입력으로 초기화
+};
+
+// 컴파일된 수식 (고정 크기, 힙 사용 없음)
+// code[0, frameLen)은 프레임 전처리(상태 함수 갱신), code[frameLen, codeLen)은 LED마다 실행
+struct CompiledExpr {
+  ExprInstr code[EXPR_MAX_CODE];
+  uint8_t   codeLen = 0;
+  uint8_t   frameLen = 0;
+  float     consts[EXPR_MAX_CONSTS];
+  uint8_t   constCount = 0;
+  char      inputs[EXPR_MAX_INPUTS][EXPR_NAME_LEN];  // InPort 이름
+  uint8_t   inputCount = 0;
+  ExprOsc   osc[EXPR_MAX_OSC];
+  uint8_t   oscCount = 0;
+  uint8_t   filters[EXPR_MAX_FILTERS];  // 상태 함수 종류 (OP_SMOOTH 등)
+  uint8_t   filterCount = 0;
+  uint8_t   maxStack = 0;   // 실행에 필요한 값 스택 깊이
+  uint8_t   depth = 0;      // 트리 중첩 깊이 (상수 접기/마스크 변환 후 실제로 내보낸 트리 기준)
+};
+
+// 명령이 유래한 원문 위치 [start, end) (프로파일 결과 표시용, 요청 시에만 생성)
+struct ExprSpan {
+  uint16_t start, end;
+};
+
+// 명령(pc)별 실행 횟수와 누적 시간 (run<true>가 채움)
+struct ExprProfile {
+  uint32_t count[EXPR_MAX_CODE];
+  uint32_t cycles[EXPR_MAX_CODE];
+
+  void clear() {
+    memset(count, 0, sizeof(count));
+    memset(cycles, 0, sizeof(cycles));
+  }
+};
+
+// LED 하나를 평가할 때의 변수 값
+struct ExprContext {
+  float theta;
+  float t;
+  int   i;
+  const float* inputs;      // resolveInputs()로 프레임마다 채운 InPort 값
+  const float* uniforms;    // 패턴 파라미터 값 (컴파일 시 넘긴 이름 순서)
+  const ExprOscState* osc;  // advanceOscillators()로 프레임마다 갱신한 오실레이터
+  ExprFilterState* filters; // advanceFilters()로 프레임마다 갱신한 상태 함수 값
+  float dt;                 // 직전 프레임과의 간격(초), 프레임 전처리에서만 사용
+};
+
+// 경량 수식 엔진 (비교 및 논리 연산자 + InPort 변수 지원)
+class ExpressionEvaluator {
+public:
+  // 수식 → 바이트코드. 실패 시 false, error()/errorPos()로 원인 확인
+  // uniformNames: 패턴 파라미터 이름. 수식에서 이 이름은 InPort 대신 OP_UNIFORM(인덱스)으로
+  // 컴파일되어, 값을 바꿔도 다시 컴파일할 필요가 없다.
+  // spans: 주어지면 명령마다 원문 위치를 기록 (EXPR_MAX_CODE개, 프로파일러용)
+  bool compile(const char* src, CompiledExpr& out,
+               const char (*uniformNames)[EXPR_NAME_LEN] = nullptr, uint8_t uniformCount = 0,
+               ExprSpan* spans = nullptr) {
+    _src = src ? src : "";
+    _spans = spans;
+    _uniformNames = uniformNames;
+    _uniformCount = uniformNames ? uniformCount : 0;
+    _err = nullptr;
+    _errPos = 0;
+    _nodeCount = 0;
+    _opTop = 0;
+    _valTop = 0;
+    out = CompiledExpr();
+
+    if (!_parse(out)) return false;
+    _foldConstants();
+    if (!_findFilters(out)) return false;
+    _findOscillators(out);
+    _rewriteMasks();
+
+    // 프레임 전처리: 상태 함수마다 인자 → OP_FILTER_STEP
+    for (uint8_t f = 0; f < out.filterCount; f++) {
+      const Node& n = _filterNodes[f];
+      uint8_t argc = 0;
+      for (int c = 0; c < 3 && n.kids[c] != NONE; c++) {
+        if (!_emit(n.kids[c], out, argc++)) return false;
+      }
+      if (!_emitOp(OP_FILTER_STEP, f, out, n)) return false;
+    }
+    out.frameLen = out.codeLen;
+
+    return _emit(_valStack[0], out);
+  }
+
+  const char* error() const { return _err; }
+  int errorPos() const { return _errPos; }
+
+  // 프레임마다 한 번: InPort 값을 조회해 values[]에 채움 (LED마다 조회하지 않음)
+  static void resolveInputs(const CompiledExpr& e, float* values) {
+    for (uint8_t k = 0; k < e.inputCount; k++) {
+      float v = port_get_inport_value(e.inputs[k]);
+      values[k] = isnan(v) ? 0.0f : v;
+    }
+  }
+
+  // 오실레이터 상태 초기화 (패턴 시작/교체 시)
+  static void resetOscillators(ExprOscState* st) {
+    for (uint8_t k = 0; k < EXPR_MAX_OSC; k++) st[k].valid = false;
+  }
+
+  // 프레임마다 한 번: 패턴 시작 후 경과 ms로 오실레이터 갱신
+  // 위상은 정수 ms * Q64 증가량에서 소수부(회전수) 상위 32비트만 취한 값 = 정확히 2π로 감긴 값이므로
+  // 가동 시간과 무관하게 정밀하다.
+  // sin/cos 값은 직전 프레임에서 dt만큼 회전하고 크기를 보정한다 (dt별 회전은 캐시).
+  static void advanceOscillators(const CompiledExpr& e, ExprOscState* st, uint32_t ms) {
+    for (uint8_t k = 0; k < e.oscCount; k++) {
+      const ExprOsc& o = e.osc[k];
+      ExprOscState& s = st[k];
+      uint32_t turns = ms * (uint32_t)(o.stepQ64 >> 32)
+                     + (uint32_t)(((uint64_t)ms * (uint32_t)o.stepQ64) >> 32);
+      s.phase = (float)turns * (2.0f * VIBE_PI / 4294967296.0f);
+      if (!o.rotate) continue;
+
+      uint32_t dt = ms - s.lastMs;
+      if (s.valid && dt < 1000 && s.sinceSync < EXPR_OSC_RESYNC) {
+        if (dt > 0) {
+          uint8_t r = (s.rotDt[0] == dt) ? 0 : (s.rotDt[1] == dt) ? 1 : 2;
+          if (r == 2) {
+            r = s.rotNext;
+            s.rotNext ^= 1;
+            float a = o.rate * (dt * 0.001f);
+            s.rotC[r] = cosf(a);
+            s.rotS[r] = sinf(a);
+            s.rotDt[r] = (uint16_t)dt;
+          }
+          float c = s.c * s.rotC[r] - s.s * s.rotS[r];
+          float n = s.s * s.rotC[r] + s.c * s.rotS[r];
+          float g = 1.5f - 0.5f * (c * c + n * n);   // |(c, s)| = 1 유지
+          s.c = c * g;
+          s.s = n * g;
+        }
+        s.sinceSync++;
+      } else {
+        float ph = s.phase + o.offset;
+        s.s = sinf(ph);
+        s.c = cosf(ph);
+        if (!s.valid) {
+          s.rotDt[0] = s.rotDt[1] = 0;
+          s.rotNext = 0;
+        }
+        s.sinceSync = 0;
+        s.valid = true;
+      }
+      s.lastMs = ms;
+    }
+  }
+
+  // 상태 함수 초기화 (패턴 시작/교체 시)
+  static void resetFilters(ExprFilterState* st) {
+    for (uint8_t k = 0; k < EXPR_MAX_FILTERS; k++) st[k].valid = false;
+  }
+
+  // 프레임마다 한 번 (resolveInputs/advanceOscillators 뒤): 상태 함수의 인자를 계산해 상태를 갱신
+  // frame: 이 프레임의 t/InPort/파라미터/오실레이터 (theta, i는 쓰이지 않음), dt: 직전 프레임과의 간격(초)
+  static void advanceFilters(const CompiledExpr& e, ExprFilterState* st, const ExprContext& frame, float dt) {
+    if (e.frameLen == 0) return;
+    ExprContext ctx = frame;
+    ctx.filters = st;
+    ctx.dt = dt;
+    _exec<false>(e, ctx, nullptr, 0, e.frameLen);
+  }
+
+  // 바이트코드 실행 (재귀 없음, 값 스택은 EXPR_STACK_SIZE로 고정)
+  static float run(const CompiledExpr& e, const ExprContext& ctx) {
+    return _exec<false>(e, ctx, nullptr, e.frameLen, e.codeLen);
+  }
+
+  // Profile = true: 명령마다 실행 횟수와 시간을 prof에 누적
+  // Profile = false는 위 run()과 같은 코드로 컴파일되어 계측 비용이 전혀 없다.
+  template <bool Profile>
+  static float run(const CompiledExpr& e, const ExprContext& ctx, ExprProfile* prof) {
+    return _exec<Profile>(e, ctx, prof, e.frameLen, e.codeLen);
+  }
+
+  // 프로파일 결과 표시용 명령 이름
+  static const char* opName(uint8_t op) {
+    static const char* const kNames[] = {
+      "const", "theta", "t", "i", "input", "param", "phase", "osc_sin", "osc_cos", "filter",
+      "neg", "not",
+      "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=", "&&", "||",
+      "sin", "cos", "tan", "abs", "sqrt", "floor", "ceil", "max", "min", "mod", "pow",
+      "noise1", "noise2", "noise3",
+      "select", "smooth", "envelope", "peak", "deriv",
+      "jmp", "jz", "jz_keep", "jnz_keep", "bool", "filter_step",
+    };
+    static_assert(sizeof(kNames) / sizeof(kNames[0]) == OP_COUNT, "opName table out of sync with ExprOp");
+    return (op < OP_COUNT) ? kNames[op] : "?";
+  }
+
+private:
+  template <bool Profile>
+  static float _exec(const CompiledExpr& e, const ExprContext& ctx, ExprProfile* prof,
+                     uint8_t begin, uint8_t end) {
+    float st[EXPR_STACK_SIZE];
+    int sp = -1;
+    uint32_t c0 = Profile ? EXPR_CYCLE_COUNT() : 0;
+
+    uint8_t pc = begin;
+    while (pc < end) {
+      const uint8_t at = pc;
+      const ExprInstr in = e.code[pc++];
+      switch (in.op) {
+        case OP_CONST: st[++sp] = e.consts[in.arg]; break;
+        case OP_THETA: st[++sp] = ctx.theta; break;
+        case OP_T:     st[++sp] = ctx.t; break;
+        case OP_I:     st[++sp] = (float)ctx.i; break;
+        case OP_INPUT: st[++sp] = ctx.inputs ? ctx.inputs[in.arg] : 0.0f; break;
+        case OP_UNIFORM: st[++sp] = ctx.uniforms ? ctx.uniforms[in.arg] : 0.0f; break;
+        case OP_PHASE:   st[++sp] = ctx.osc[in.arg].phase; break;
+        case OP_OSC_SIN: st[++sp] = ctx.osc[in.arg].s; break;
+        case OP_OSC_COS: st[++sp] = ctx.osc[in.arg].c; break;
+        case OP_FILTER:  st[++sp] = ctx.filters ? ctx.filters[in.arg].y : 0.0f; break;
+
+        case OP_FILTER_STEP: {
+          const uint8_t op = e.filters[in.arg];
+          const uint8_t argc = _filterArgc(op);
+          sp -= argc;
+          _filterStep(op, ctx.filters[in.arg], st + sp + 1, ctx.dt);
+        } break;
+
+        case OP_JMP: pc = in.arg; break;
+        case OP_JZ:  if (st[sp--] == 0) pc = in.arg; break;
+        case OP_JZ_KEEP:
+          if (st[sp] == 0) pc = in.arg;
+          else sp--;
+          break;
+        case OP_JNZ_KEEP:
+          if (st[sp] != 0) { st[sp] = 1.0f; pc = in.arg; }
+          else sp--;
+          break;
+        case OP_BOOL: st[sp] = (st[sp] != 0) ? 1.0f : 0.0f; break;
+
+        case OP_NEG: case OP_NOT:
+        case OP_SIN: case OP_COS: case OP_TAN: case OP_ABS:
+        case OP_SQRT: case OP_FLOOR: case OP_CEIL: case OP_NOISE1:
+          st[sp] = _unary(in.op, st[sp]);
+          break;
+
+        case OP_NOISE3:
+          sp -= 2;
+          st[sp] = _noise3(st[sp], st[sp + 1], st[sp + 2]);
+          break;
+
+        default: {
+          // 이항 연산: 스택 상단 두 값을 하나로
+          float b = st[sp--];
+          float a = st[sp];
+          st[sp] = _binary(in.op, a, b);
+        } break;
+      }
+
+      if (Profile) {
+        uint32_t c1 = EXPR_CYCLE_COUNT();
+        prof->count[at]++;
+        prof->cycles[at] += c1 - c0;
+        c0 = c1;
+      }
+    }
+    return (sp >= 0) ? st[sp] : 0.0f;
+  }
+
+  static uint8_t _filterArgc(uint8_t op) {
+    switch (op) {
+      case OP_ENVELOPE: return 3;
+      case OP_DERIV:    return 1;
+      default:          return 2;  // smooth, peak
+    }
+  }
+
+  // 시정수 tau(초)인 1차 추종의 프레임 계수: 1 - e^(-dt/tau)
+  static float _follow(float dt, float tau) {
+    return (tau <= 0) ? 1.0f : 1.0f - expf(-dt / tau);
+  }
+
+  // 상태 함수 한 단계. a: 인자 (x, 시정수...)
+  //   smooth(x, tau)               1차 저역 통과
+  //   envelope(x, attack, release) |x| 추종, 오를 때 attack / 내릴 때 release 시정수
+  //   peak(x, decay)               즉시 상승, decay 시정수로 하강
+  //   deriv(x)                     초당 변화량
+  static void _filterStep(uint8_t op, ExprFilterState& s, const float* a, float dt) {
+    float x = (op == OP_ENVELOPE) ? fabsf(a[0]) : a[0];
+    if (!s.valid) {
+      s.y = (op == OP_DERIV) ? 0.0f : x;
+      s.prev = x;
+      s.valid = true;
+      return;
+    }
+    switch (op) {
+      case OP_SMOOTH:   s.y += (x - s.y) * _follow(dt, a[1]); break;
+      case OP_ENVELOPE: s.y += (x - s.y) * _follow(dt, (x > s.y) ? a[1] : a[2]); break;
+      case OP_PEAK:     s.y = (x > s.y) ? x : s.y + (x - s.y) * _follow(dt, a[1]); break;
+      case OP_DERIV:    if (dt > 0) s.y = (x - s.prev) / dt; break;
+    }
+    s.prev = x;
+  }
+
+  // ===== 구문 트리 =====
+  static constexpr uint8_t NONE = 0xFF;
+
+  struct Node {
+    uint8_t op;
+    uint8_t arg;         // OP_INPUT/OP_UNIFORM: 입력/파라미터 인덱스
+    uint8_t kids[3];     // OP_SELECT만 3개 (조건, 참, 거짓)
+    uint8_t depth;
+    float   value;       // OP_CONST
+    uint16_t start, end; // 원문 위치 (프로파일러용)
+  };
+
+  // 연산자 스택 항목
+  enum : uint8_t { K_UNARY, K_BINARY, K_PAREN, K_FUNC, K_TERNARY, K_TCOLON };
+  struct OpEntry {
+    uint8_t kind;
+    uint8_t op;
+    uint8_t argc;        // K_FUNC: 지금까지 읽은 인자 수
+    uint16_t pos;
+  };
+
+  static constexpr uint8_t OP_STACK_SIZE = EXPR_MAX_DEPTH * 2;
+
+  const char* _src = "";
+  const char* _err = nullptr;
+  int _errPos = 0;
+  ExprSpan* _spans = nullptr;
+  const char (*_uniformNames)[EXPR_NAME_LEN] = nullptr;
+  uint8_t _uniformCount = 0;
+
+  Node    _nodes[EXPR_MAX_NODES];
+  uint8_t _nodeCount = 0;
+  Node    _filterNodes[EXPR_MAX_FILTERS];  // 분리된 상태 함수 (인자 트리 참조)
+  OpEntry _opStack[OP_STACK_SIZE];
+  uint8_t _opTop = 0;
+  uint8_t _valStack[EXPR_MAX_NODES];
+  uint8_t _valTop = 0;
+
+  static float _unary(uint8_t op, float a) {
+    switch (op) {
+      case OP_NEG:   return -a;
+      case OP_NOT:   return (a == 0) ? 1.0f : 0.0f;
+      case OP_SIN:   return sinf(a);
+      case OP_COS:   return cosf(a);
+      case OP_TAN:   return tanf(a);
+      case OP_ABS:   return fabsf(a);
+      case OP_SQRT:  return sqrtf(a);
+      case OP_FLOOR: return floorf(a);
+      case OP_CEIL:  return ceilf(a);
+      case OP_NOISE1: return GradientNoise::noise1(GradientNoise::fixed(a)) * (1.0f / 65536.0f);
+      default:       return 0;
+    }
+  }
+
+  static float _binary(uint8_t op, float a, float b) {
+    switch (op) {
+      case OP_ADD:  return a + b;
+      case OP_SUB:  return a - b;
+      case OP_MUL:  return a * b;
+      case OP_DIV:  return (b != 0) ? (a / b) : 0;
+      case OP_MOD:
+      case OP_FMOD: return fmodf(a, b);
+      case OP_LT:   return (a <  b) ? 1.0f : 0.0f;
+      case OP_GT:   return (a >  b) ? 1.0f : 0.0f;
+      case OP_LE:   return (a <= b) ? 1.0f : 0.0f;
+      case OP_GE:   return (a >= b) ? 1.0f : 0.0f;
+      case OP_EQ:   return (fabsf(a - b) <  0.0001f) ? 1.0f : 0.0f;
+      case OP_NE:   return (fabsf(a - b) >= 0.0001f) ? 1.0f : 0.0f;
+      case OP_AND:  return (a != 0 && b != 0) ? 1.0f : 0.0f;
+      case OP_OR:   return (a != 0 || b != 0) ? 1.0f : 0.0f;
+      case OP_MAX:  return (a > b) ? a : b;
+      case OP_MIN:  return (a < b) ? a : b;
+      case OP_POW:  return powf(a, b);
+      case OP_NOISE2:
+        return GradientNoise::noise2(GradientNoise::fixed(a), GradientNoise::fixed(b)) * (1.0f / 65536.0f);
+      default:      return 0;
+    }
+  }
+
+  static float _noise3(float x, float y, float z) {
+    return GradientNoise::noise3(GradientNoise::fixed(x), GradientNoise::fixed(y), GradientNoise::fixed(z)) *
+           (1.0f / 65536.0f);
+  }
+
+  struct FuncDef {
+    const char* name;
+    uint8_t op;
+    uint8_t argc;
+  };
+
+  static const FuncDef* _funcs(uint8_t& count) {
+    static const FuncDef kFuncs[] = {
+      { "sin", OP_SIN, 1 },   { "cos", OP_COS, 1 },     { "tan", OP_TAN, 1 },
+      { "abs", OP_ABS, 1 },   { "sqrt", OP_SQRT, 1 },   { "floor", OP_FLOOR, 1 },
+      { "ceil", OP_CEIL, 1 }, { "max", OP_MAX, 2 },     { "min", OP_MIN, 2 },
+      { "mod", OP_FMOD, 2 },  { "pow", OP_POW, 2 },     { "if", OP_SELECT, 3 },
+      { "noise1", OP_NOISE1, 1 }, { "noise2", OP_NOISE2, 2 }, { "noise3", OP_NOISE3, 3 },
+      { "smooth", OP_SMOOTH, 2 }, { "envelope", OP_ENVELOPE, 3 },
+      { "peak", OP_PEAK, 2 },     { "deriv", OP_DERIV, 1 },
+    };
+    count = sizeof(kFuncs) / sizeof(kFuncs[0]);
+    return kFuncs;
+  }
+
+  static const FuncDef* _findFunc(const char* name) {
+    uint8_t count;
+    const FuncDef* f = _funcs(count);
+    for (uint8_t k = 0; k < count; k++) {
+      if (strcmp(f[k].name, name) == 0) return &f[k];
+    }
+    return nullptr;
+  }
+
+  static const FuncDef* _findFunc(uint8_t op) {
+    uint8_t count;
+    const FuncDef* f = _funcs(count);
+    for (uint8_t k = 0; k < count; k++) {
+      if (f[k].op == op) return &f[k];
+    }
+    return nullptr;
+  }
+
+  // 이항 연산자 우선순위 (클수록 먼저). 단항 연산자는 항상 이보다 높다
+  static uint8_t _precedence(uint8_t op) {
+    switch (op) {
+      case OP_OR:  return 1;
+      case OP_AND: return 2;
+      case OP_LT: case OP_GT: case OP_LE: case OP_GE: case OP_EQ: case OP_NE: return 3;
+      case OP_ADD: case OP_SUB: return 4;
+      default: return 5; // * / %
+    }
+  }
+
+  bool _fail(const char* msg, size_t pos) {
+    if (!_err) {
+      _err = msg;
+      _errPos = (int)pos;
+    }
+    return false;
+  }
+
+  void _skipWhitespace(size_t& pos) const {
+    while (isspace((unsigned char)_src[pos])) pos++;
+  }
+
+  bool _newNode(uint8_t op, float value, uint8_t arg, uint8_t a, uint8_t b, size_t pos, uint8_t c = NONE) {
+    if (_nodeCount >= EXPR_MAX_NODES) return _fail("expression too long", pos);
+    if (_valTop >= EXPR_MAX_NODES) return _fail("expression too long", pos);
+
+    uint8_t depth = 1;
+    if (a != NONE && _nodes[a].depth + 1 > depth) depth = _nodes[a].depth + 1;
+    if (b != NONE && _nodes[b].depth + 1 > depth) depth = _nodes[b].depth + 1;
+    if (c != NONE && _nodes[c].depth + 1 > depth) depth = _nodes[c].depth + 1;
+    if (depth > EXPR_MAX_DEPTH) return _fail("nested too deeply", pos);
+
+    Node& n = _nodes[_nodeCount];
+    n.op = op;
+    n.arg = arg;
+    n.kids[0] = a;
+    n.kids[1] = b;
+    n.kids[2] = c;
+    n.depth = depth;
+    n.start = (uint16_t)pos;
+    n.end = (uint16_t)(pos + 1);
+    const uint8_t kids[3] = { a, b, c };
+    for (uint8_t k : kids) {
+      if (k == NONE) continue;
+      if (_nodes[k].start < n.start) n.start = _nodes[k].start;
+      if (_nodes[k].end > n.end) n.end = _nodes[k].end;
+    }
+    n.value = value;
+    _valStack[_valTop++] = _nodeCount++;
+    return true;
+  }
+
+  bool _pushOp(uint8_t kind, uint8_t op, size_t pos) {
+    if (_opTop >= OP_STACK_SIZE) return _fail("nested too deeply", pos);
+    _opStack[_opTop].kind = kind;
+    _opStack[_opTop].op = op;
+    _opStack[_opTop].argc = 1;
+    _opStack[_opTop].pos = (uint16_t)pos;
+    _opTop++;
+    return true;
+  }
+
+  // 연산자 스택 상단 하나를 트리 노드로 환원
+  bool _reduceTop() {
+    const OpEntry e = _opStack[--_opTop];
+    if (e.kind == K_TERNARY) return _fail("expected ':'", e.pos);
+    uint8_t argc = (e.kind == K_BINARY) ? 2 : (e.kind == K_FUNC ? e.argc : (e.kind == K_TCOLON ? 3 : 1));
+    if (_valTop < argc) return _fail("missing operand", e.pos);
+
+    uint8_t c = (argc == 3) ? _valStack[--_valTop] : NONE;
+    uint8_t b = (argc >= 2) ? _valStack[--_valTop] : NONE;
+    uint8_t a = _valStack[--_valTop];
+    return _newNode(e.op, 0.0f, 0, a, b, e.pos, c);
+  }
+
+  // 괄호/함수 여는 지점까지 환원
+  bool _reduceToOpen() {
+    while (_opTop > 0) {
+      uint8_t kind = _opStack[_opTop - 1].kind;
+      if (kind == K_PAREN || kind == K_FUNC) return true;
+      if (!_reduceTop()) return false;
+    }
+    return true;
+  }
+
+  static bool _readBinary(const char* p, uint8_t& op, uint8_t& len) {
+    len = 2;
+    if (p[0] == '|' && p[1] == '|') { op = OP_OR;  return true; }
+    if (p[0] == '&' && p[1] == '&') { op = OP_AND; return true; }
+    if (p[0] == '<' && p[1] == '=') { op = OP_LE;  return true; }
+    if (p[0] == '>' && p[1] == '=') { op = OP_GE;  return true; }
+    if (p[0] == '=' && p[1] == '=') { op = OP_EQ;  return true; }
+    if (p[0] == '!' && p[1] == '=') { op = OP_NE;  return true; }
+    len = 1;
+    switch (p[0]) {
+      case '<': op = OP_LT;  return true;
+      case '>': op = OP_GT;  return true;
+      case '+': op = OP_ADD; return true;
+      case '-': op = OP_SUB; return true;
+      case '*': op = OP_MUL; return true;
+      case '/': op = OP_DIV; return true;
+      case '%': op = OP_MOD; return true;
+    }
+    return false;
+  }
+
+  uint8_t _uniformIndex(const char* name) const {
+    for (uint8_t k = 0; k < _uniformCount; k++) {
+      if (strcmp(_uniformNames[k], name) == 0) return k;
+    }
+    return NONE;
+  }
+
+  uint8_t _inputIndex(const char* name, CompiledExpr& out, size_t pos) {
+    for (uint8_t k = 0; k < out.inputCount; k++) {
+      if (strcmp(out.inputs[k], name) == 0) return k;
+    }
+    if (out.inputCount >= EXPR_MAX_INPUTS) {
+      _fail("too many input variables", pos);
+      return NONE;
+    }
+    memcpy(out.inputs[out.inputCount], name, strlen(name) + 1); // 길이는 호출 전에 검사됨
+    return out.inputCount++;
+  }
+
+  // Shunting-yard 파서: 입력을 한 번 훑으며 구문 트리를 만든다
+  bool _parse(CompiledExpr& out) {
+    size_t pos = 0;
+    bool expectOperand = true;
+
+    for (;;) {
+      _skipWhitespace(pos);
+      const char c = _src[pos];
+
+      if (expectOperand) {
+        if (c == '\0') return _fail("unexpected end of expression", pos);
+
+        // 단항 연산자
+        if (c == '-') { if (!_pushOp(K_UNARY, OP_NEG, pos)) return false; pos++; continue; }
+        if (c == '!') { if (!_pushOp(K_UNARY, OP_NOT, pos)) return false; pos++; continue; }
+        if (c == '+') { pos++; continue; }
+
+        // 괄호
+        if (c == '(') { if (!_pushOp(K_PAREN, 0, pos)) return false; pos++; continue; }
+
+        // 숫자
+        if (isdigit((unsigned char)c) || c == '.') {
+          size_t start = pos;
+          while (isdigit((unsigned char)_src[pos]) || _src[pos] == '.') pos++;
+          char buffer[32];
+          size_t len = (pos - start < 31) ? (pos - start) : 31;
+          memcpy(buffer, _src + start, len);
+          buffer[len] = '\0';
+          if (!_newNode(OP_CONST, (float)atof(buffer), 0, NONE, NONE, start)) return false;
+          _nodes[_nodeCount - 1].end = (uint16_t)pos;
+          expectOperand = false;
+          continue;
+        }
+
+        // 변수 또는 함수
+        if (isalpha((unsigned char)c) || c == '_') {
+          size_t start = pos;
+          while (isalnum((unsigned char)_src[pos]) || _src[pos] == '_') pos++;
+          char name[EXPR_NAME_LEN * 2];
+          size_t len = (pos - start < sizeof(name) - 1) ? (pos - start) : sizeof(name) - 1;
+          memcpy(name, _src + start, len);
+          name[len] = '\0';
+          const size_t nameEnd = pos;
+
+          _skipWhitespace(pos);
+          if (_src[pos] == '(') {
+            const FuncDef* f = _findFunc(name);
+            if (!f) return _fail("unknown function", start);
+            if (!_pushOp(K_FUNC, f->op, start)) return false;
+            pos++;
+            continue;
+          }
+
+          bool ok;
+          // ===== 내장 변수 =====
+          if (strcmp(name, "theta") == 0)   ok = _newNode(OP_THETA, 0, 0, NONE, NONE, start);
+          else if (strcmp(name, "t") == 0)  ok = _newNode(OP_T, 0, 0, NONE, NONE, start);
+          else if (strcmp(name, "i") == 0)  ok = _newNode(OP_I, 0, 0, NONE, NONE, start);
+          else if (strcmp(name, "pi") == 0) ok = _newNode(OP_CONST, VIBE_PI, 0, NONE, NONE, start);
+          else if (_uniformIndex(name) != NONE) {
+            // ===== 패턴 파라미터 (set_param으로 변경) =====
+            ok = _newNode(OP_UNIFORM, 0, _uniformIndex(name), NONE, NONE, start);
+          } else {
+            // ===== ★ InPort 변수 (프레임마다 조회) =====
+            if (len >= EXPR_NAME_LEN) return _fail("variable name too long", start);
+            uint8_t k = _inputIndex(name, out, start);
+            if (k == NONE) return false;
+            ok = _newNode(OP_INPUT, 0, k, NONE, NONE, start);
+          }
+          if (!ok) return false;
+          _nodes[_nodeCount - 1].end = (uint16_t)nameEnd;
+          expectOperand = false;
+          continue;
+        }
+
+        return _fail("expected a value", pos);
+      }
+
+      // ----- 연산자 자리 -----
+      if (c == '\0') break;
+
+      if (c == ')') {
+        if (!_reduceToOpen()) return false;
+        if (_opTop == 0) return _fail("unbalanced ')'", pos);
+        OpEntry& open = _opStack[_opTop - 1];
+        if (open.kind == K_PAREN) {
+          // 괄호까지 포함한 위치로 확장
+          if (_valTop > 0) {
+            Node& inner = _nodes[_valStack[_valTop - 1]];
+            if (open.pos < inner.start) inner.start = open.pos;
+            inner.end = (uint16_t)(pos + 1);
+          }
+          _opTop--;
+        } else {
+          if (open.argc != _findFunc(open.op)->argc) return _fail("wrong number of arguments", open.pos);
+          if (!_reduceTop()) return false;
+          _nodes[_nodeCount - 1].end = (uint16_t)(pos + 1);
+        }
+        pos++;
+        continue;
+      }
+
+      if (c == ',') {
+        if (!_reduceToOpen()) return false;
+        if (_opTop == 0 || _opStack[_opTop - 1].kind != K_FUNC) return _fail("unexpected ','", pos);
+        _opStack[_opTop - 1].argc++;
+        pos++;
+        expectOperand = true;
+        continue;
+      }
+
+      // 조건 연산자 (우선순위 최저, 우결합): c ? a : b
+      if (c == '?') {
+        while (_opTop > 0 && (_opStack[_opTop - 1].kind == K_UNARY || _opStack[_opTop - 1].kind == K_BINARY)) {
+          if (!_reduceTop()) return false;
+        }
+        if (!_pushOp(K_TERNARY, OP_SELECT, pos)) return false;
+        pos++;
+        expectOperand = true;
+        continue;
+      }
+      if (c == ':') {
+        // 짝이 되는 '?'까지 환원 (안쪽의 완성된 조건식 포함)
+        while (_opTop > 0) {
+          uint8_t kind = _opStack[_opTop - 1].kind;
+          if (kind == K_TERNARY || kind == K_PAREN || kind == K_FUNC) break;
+          if (!_reduceTop()) return false;
+        }
+        if (_opTop == 0 || _opStack[_opTop - 1].kind != K_TERNARY) return _fail("unexpected ':'", pos);
+        _opStack[_opTop - 1].kind = K_TCOLON;
+        pos++;
+        expectOperand = true;
+        continue;
+      }
+
+      uint8_t op, len;
+      if (!_readBinary(_src + pos, op, len)) return _fail("unexpected character", pos);
+
+      // 우선순위가 같거나 높은 연산자를 먼저 환원 (좌결합)
+      uint8_t prec = _precedence(op);
+      while (_opTop > 0) {
+        const OpEntry& top = _opStack[_opTop - 1];
+        if (top.kind == K_UNARY || (top.kind == K_BINARY && _precedence(top.op) >= prec)) {
+          if (!_reduceTop()) return false;
+        } else {
+          break;
+        }
+      }
+      if (!_pushOp(K_BINARY, op, pos)) return false;
+      pos += len;
+      expectOperand = true;
+    }
+
+    // 남은 연산자 모두 환원
+    while (_opTop > 0) {
+      uint8_t kind = _opStack[_opTop - 1].kind;
+      if (kind == K_PAREN || kind == K_FUNC) return _fail("missing ')'", _opStack[_opTop - 1].pos);
+      if (kind == K_TERNARY) return _fail("expected ':'", _opStack[_opTop - 1].pos);
+      if (!_reduceTop()) return false;
+    }
+    if (_valTop != 1) return _fail("malformed expression", pos);
+    return true;
+  }
+
+  bool _isConst(uint8_t node, float v) const {
+    return node != NONE && _nodes[node].op == OP_CONST && _nodes[node].value == v;
+  }
+
+  // 결과가 항상 0 또는 1인 노드 (비교/논리)
+  bool _isBool(uint8_t node) const {
+    switch (_nodes[node].op) {
+      case OP_LT: case OP_GT: case OP_LE: case OP_GE: case OP_EQ: case OP_NE:
+      case OP_AND: case OP_OR: case OP_NOT:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // 피연산자가 모두 상수인 노드를 상수로 접는다 (예: 2*pi).
+  // 결과가 같은 단순화도 함께 적용: c ? a : b (c 상수), 불리언 * 0 → 0, x + 0 → x
+  // 노드는 자식이 항상 부모보다 먼저 만들어지므로 인덱스 순서대로 한 번 훑으면 된다.
+  void _foldConstants() {
+    for (uint8_t k = 0; k < _nodeCount; k++) {
+      Node& n = _nodes[k];
+      if (n.kids[0] == NONE || _isFilter(n.op)) continue;
+
+      if (n.op == OP_SELECT) {
+        if (_nodes[n.kids[0]].op == OP_CONST) {
+          n = _nodes[_nodes[n.kids[0]].value != 0 ? n.kids[1] : n.kids[2]];
+        }
+        continue;
+      }
+      if (n.op == OP_MUL && ((_isConst(n.kids[0], 0) && _isBool(n.kids[1])) ||
+                             (_isConst(n.kids[1], 0) && _isBool(n.kids[0])))) {
+        n = _nodes[_isConst(n.kids[0], 0) ? n.kids[0] : n.kids[1]];
+        continue;
+      }
+      if (n.op == OP_ADD && (_isConst(n.kids[0], 0) || _isConst(n.kids[1], 0))) {
+        n = _nodes[_isConst(n.kids[0], 0) ? n.kids[1] : n.kids[0]];
+        continue;
+      }
+
+      if (_nodes[n.kids[0]].op != OP_CONST) continue;
+      if (n.kids[1] != NONE && _nodes[n.kids[1]].op != OP_CONST) continue;
+      if (n.kids[2] != NONE && _nodes[n.kids[2]].op != OP_CONST) continue;
+      float a = _nodes[n.kids[0]].value;
+      if (n.kids[2] != NONE) n.value = _noise3(a, _nodes[n.kids[1]].value, _nodes[n.kids[2]].value);
+      else if (n.kids[1] != NONE) n.value = _binary(n.op, a, _nodes[n.kids[1]].value);
+      else n.value = _unary(n.op, a);
+      n.op = OP_CONST;
+      n.kids[0] = n.kids[1] = n.kids[2] = NONE;
+    }
+  }
+
+  // 두 부분 트리가 같은 식인지 (명시적 스택으로 비교)
+  bool _sameTree(uint8_t a, uint8_t b) const {
+    uint8_t stack[EXPR_MAX_NODES][2];
+    int top = 0;
+    stack[0][0] = a;
+    stack[0][1] = b;
+    while (top >= 0) {
+      uint8_t x = stack[top][0], y = stack[top][1];
+      top--;
+      if (x == y) continue;
+      if (x == NONE || y == NONE) return false;
+      const Node& nx = _nodes[x];
+      const Node& ny = _nodes[y];
+      if (nx.op != ny.op || nx.arg != ny.arg) return false;
+      if (nx.op == OP_CONST && nx.value != ny.value) return false;
+      for (int c = 0; c < 3; c++) {
+        if (top + 1 >= EXPR_MAX_NODES) return false;
+        stack[++top][0] = nx.kids[c];
+        stack[top][1] = ny.kids[c];
+      }
+    }
+    return true;
+  }
+
+  // c2 == !c1 인지 (a<b / a>=b, a>b / a<=b, a==b / a!=b, x / !x)
+  bool _complementary(uint8_t c1, uint8_t c2) const {
+    const Node& x = _nodes[c1];
+    const Node& y = _nodes[c2];
+    if (x.op == OP_NOT) return _sameTree(x.kids[0], c2);
+    if (y.op == OP_NOT) return _sameTree(y.kids[0], c1);
+    uint8_t inv;
+    switch (x.op) {
+      case OP_LT: inv = OP_GE; break;
+      case OP_GE: inv = OP_LT; break;
+      case OP_GT: inv = OP_LE; break;
+      case OP_LE: inv = OP_GT; break;
+      case OP_EQ: inv = OP_NE; break;
+      case OP_NE: inv = OP_EQ; break;
+      default: return false;
+    }
+    return y.op == inv && _sameTree(x.kids[0], y.kids[0]) && _sameTree(x.kids[1], y.kids[1]);
+  }
+
+  // node가 "조건 마스크 × 값"이면 (조건, 값)을 돌려준다: SELECT(c, v, 0), c*v, v*c
+  bool _masked(uint8_t node, uint8_t& cond, uint8_t& value) const {
+    const Node& n = _nodes[node];
+    if (n.op == OP_SELECT && _isConst(n.kids[2], 0)) {
+      cond = n.kids[0];
+      value = n.kids[1];
+      return true;
+    }
+    if (n.op != OP_MUL) return false;
+    if (_isBool(n.kids[0])) { cond = n.kids[0]; value = n.kids[1]; return true; }
+    if (_isBool(n.kids[1])) { cond = n.kids[1]; value = n.kids[0]; return true; }
+    return false;
+  }
+
+  // 마스크 곱셈 관용구 → 조건식 (결과는 값이 유한한 한 동일)
+  //   (c)*X                 → c ? X : 0       (X가 연산일 때만, 상수/변수면 곱셈이 더 싸다)
+  //   (c)*X + (!c)*Y        → c ? X : Y
+  void _rewriteMasks() {
+    uint8_t zero = NONE;
+    for (uint8_t k = 0; k < _nodeCount; k++) {
+      Node& n = _nodes[k];
+      uint8_t c1, v1, c2, v2;
+
+      if (n.op == OP_ADD && _masked(n.kids[0], c1, v1) && _masked(n.kids[1], c2, v2) &&
+          _complementary(c1, c2)) {
+        n.op = OP_SELECT;
+        n.kids[0] = c1;
+        n.kids[1] = v1;
+        n.kids[2] = v2;
+        continue;
+      }
+
+      if (n.op == OP_MUL && _masked(k, c1, v1) && _nodes[v1].kids[0] != NONE) {
+        if (zero == NONE) {
+          if (_nodeCount >= EXPR_MAX_NODES) return;
+          zero = _nodeCount++;
+          _nodes[zero] = Node();
+          _nodes[zero].op = OP_CONST;
+          _nodes[zero].kids[0] = _nodes[zero].kids[1] = _nodes[zero].kids[2] = NONE;
+          _nodes[zero].depth = 1;
+          _nodes[zero].start = n.start;
+          _nodes[zero].end = n.end;
+        }
+        n.op = OP_SELECT;
+        n.kids[0] = c1;
+        n.kids[1] = v1;
+        n.kids[2] = zero;
+      }
+    }
+  }
+
+  static bool _isFilter(uint8_t op) {
+    return op == OP_SMOOTH || op == OP_ENVELOPE || op == OP_PEAK || op == OP_DERIV;
+  }
+
+  // 부분 트리가 LED마다 달라지는지 (theta 또는 i 참조)
+  bool _perLed(uint8_t root) const {
+    uint8_t stack[EXPR_MAX_NODES];
+    int top = 0;
+    stack[0] = root;
+    while (top >= 0) {
+      const Node& n = _nodes[stack[top--]];
+      if (n.op == OP_THETA || n.op == OP_I) return true;
+      for (int c = 0; c < 3; c++) {
+        if (n.kids[c] != NONE && top + 1 < EXPR_MAX_NODES) stack[++top] = n.kids[c];
+      }
+    }
+    return false;
+  }
+
+  // 상태 함수 분리: 노드 사본을 _filterNodes에 두고 트리에서는 OP_FILTER 잎으로 바꾼다.
+  // 자식이 먼저 처리되므로 중첩(smooth(deriv(x), 0.1))은 안쪽 상태가 먼저 갱신된다.
+  bool _findFilters(CompiledExpr& out) {
+    for (uint8_t k = 0; k < _nodeCount; k++) {
+      Node& n = _nodes[k];
+      if (!_isFilter(n.op)) continue;
+      for (int c = 0; c < 3; c++) {
+        if (n.kids[c] != NONE && _perLed(n.kids[c])) {
+          return _fail("stateful function argument depends on theta or i", _nodes[n.kids[c]].start);
+        }
+      }
+      if (out.filterCount >= EXPR_MAX_FILTERS) return _fail("too many stateful functions", n.start);
+      _filterNodes[out.filterCount] = n;
+      out.filters[out.filterCount] = n.op;
+      _makeLeaf(k, OP_FILTER, out.filterCount++);
+    }
+    return true;
+  }
+
+  // node가 (상수) * t 꼴이면 rate를 돌려준다 (t*2*pi, -t/4, 3*t 등, 곱/나눗셈/부호 사슬)
+  bool _linearInT(uint8_t node, float& rate) const {
+    rate = 1.0f;
+    for (;;) {
+      const Node& n = _nodes[node];
+      if (n.op == OP_T) return true;
+      if (n.op == OP_NEG) { rate = -rate; node = n.kids[0]; continue; }
+      if (n.op != OP_MUL && n.op != OP_DIV) return false;
+      const Node& a = _nodes[n.kids[0]];
+      const Node& b = _nodes[n.kids[1]];
+      if (b.op == OP_CONST) {
+        if (n.op == OP_DIV) {
+          if (b.value == 0) return false;
+          rate /= b.value;
+        } else {
+          rate *= b.value;
+        }
+        node = n.kids[0];
+      } else if (n.op == OP_MUL && a.op == OP_CONST) {
+        rate *= a.value;
+        node = n.kids[1];
+      } else {
+        return false;
+      }
+    }
+  }
+
+  uint8_t _oscIndex(float rate, float offset, bool rotate, CompiledExpr& out) {
+    if (rate == 0 || fabsf(rate) > EXPR_OSC_MAX_RATE) return NONE;
+    for (uint8_t k = 0; k < out.oscCount; k++) {
+      if (out.osc[k].rate == rate && out.osc[k].offset == offset) {
+        out.osc[k].rotate |= rotate;
+        return k;
+      }
+    }
+    if (out.oscCount >= EXPR_MAX_OSC) return NONE;
+    ExprOsc& o = out.osc[out.oscCount];
+    o.rate = rate;
+    o.offset = offset;
+    o.rotate = rotate;
+    // rad/s → ms당 Q64 회전수 (컴파일 시 한 번, double로 계산. |rate| 상한 덕분에 0.5회전/ms 미만)
+    o.stepQ64 = (uint64_t)(int64_t)((double)rate / (2000.0 * 3.14159265358979) * 18446744073709551616.0);
+    return out.oscCount++;
+  }
+
+  void _makeLeaf(uint8_t node, uint8_t op, uint8_t arg) {
+    _nodes[node].op = op;
+    _nodes[node].arg = arg;
+    _nodes[node].kids[0] = _nodes[node].kids[1] = _nodes[node].kids[2] = NONE;
+  }
+
+  // sin/cos(a*t + b) 탐지
+  //   b가 상수(또는 없음) → 식 전체를 OP_OSC_SIN/COS로 (프레임당 한 번 점화식 갱신, LED마다 삼각함수 없음)
+  //   b가 LED마다 다름(theta 등) → a*t 항만 OP_PHASE로 (감긴 위상이라 큰 인자 정밀도 손실 없음)
+  void _findOscillators(CompiledExpr& out) {
+    for (uint8_t k = 0; k < _nodeCount; k++) {
+      Node& n = _nodes[k];
+      if (n.op != OP_SIN && n.op != OP_COS) continue;
+      const uint8_t oscOp = (n.op == OP_SIN) ? OP_OSC_SIN : OP_OSC_COS;
+      const uint8_t arg = n.kids[0];
+      const Node& a = _nodes[arg];
+      float rate;
+      uint8_t idx;
+
+      if (_linearInT(arg, rate)) {
+        if ((idx = _oscIndex(rate, 0.0f, true, out)) != NONE) _makeLeaf(k, oscOp, idx);
+        continue;
+      }
+      if (a.op != OP_ADD && a.op != OP_SUB) continue;
+
+      const uint8_t l = a.kids[0], r = a.kids[1];
+      const bool lConst = _nodes[l].op == OP_CONST, rConst = _nodes[r].op == OP_CONST;
+      if (rConst && _linearInT(l, rate)) {
+        // a*t ± c
+        float off = (a.op == OP_ADD) ? _nodes[r].value : -_nodes[r].value;
+        if ((idx = _oscIndex(rate, off, true, out)) != NONE) _makeLeaf(k, oscOp, idx);
+      } else if (lConst && _linearInT(r, rate)) {
+        // c ± a*t
+        if (a.op == OP_SUB) rate = -rate;
+        if ((idx = _oscIndex(rate, _nodes[l].value, true, out)) != NONE) _makeLeaf(k, oscOp, idx);
+      } else if (_linearInT(l, rate)) {
+        if ((idx = _oscIndex(rate, 0.0f, false, out)) != NONE) _makeLeaf(l, OP_PHASE, idx);
+      } else if (_linearInT(r, rate)) {
+        if ((idx = _oscIndex(rate, 0.0f, false, out)) != NONE) _makeLeaf(r, OP_PHASE, idx);
+      }
+    }
+  }
+
+  uint8_t _constIndex(float v, CompiledExpr& out) {
+    for (uint8_t k = 0; k < out.constCount; k++) {
+      if (out.consts[k] == v) return k;
+    }
+    if (out.constCount >= EXPR_MAX_CONSTS) return NONE;
+    out.consts[out.constCount] = v;
+    return out.constCount++;
+  }
+
+  bool _emitOp(uint8_t op, uint8_t arg, CompiledExpr& out, const Node& from) {
+    if (out.codeLen >= EXPR_MAX_CODE) return _fail("expression too long", 0);
+    if (_spans) {
+      _spans[out.codeLen].start = from.start;
+      _spans[out.codeLen].end = from.end;
+    }
+    out.code[out.codeLen].op = op;
+    out.code[out.codeLen].arg = arg;
+    out.codeLen++;
+    return true;
+  }
+
+  // 트리 → 바이트코드 (명시적 스택으로 후위 순회)
+  // 조건식과 &&/||는 자식 사이에 점프를 넣는다:
+  //   c ? a : b  →  c JZ(L1) a JMP(L2) L1: b L2:
+  //   a && b     →  a JZ_KEEP(L) b BOOL L:
+  //   a || b     →  a JNZ_KEEP(L) b BOOL L:
+  // sp0: 이미 스택에 쌓여 있는 값 수 (프레임 전처리의 앞선 인자)
+  bool _emit(uint8_t root, CompiledExpr& out, int sp0 = 0) {
+    struct Frame { uint8_t node; uint8_t next; uint8_t hooks; uint8_t jump; };
+    Frame stack[EXPR_MAX_DEPTH + 1];
+    int top = 0;
+    stack[0].node = root;
+    stack[0].next = 0;
+    stack[0].hooks = 0;
+    int sp = sp0;
+    if (out.depth < 1) out.depth = 1;
+
+    while (top >= 0) {
+      Frame& f = stack[top];
+      const Node& n = _nodes[f.node];
+      const bool lazy = (n.op == OP_SELECT || n.op == OP_AND || n.op == OP_OR);
+
+      // 분기 노드: 첫째/둘째 자식 직후 점프 삽입 (점프 대상은 나중에 채움)
+      if (lazy && f.hooks < f.next && f.next < 3 && n.kids[f.next] != NONE) {
+        if (f.next == 1) {
+          uint8_t op = (n.op == OP_SELECT) ? OP_JZ : (n.op == OP_AND ? OP_JZ_KEEP : OP_JNZ_KEEP);
+          if (!_emitOp(op, 0, out, n)) return false;
+        } else {
+          if (!_emitOp(OP_JMP, 0, out, n)) return false;
+          out.code[f.jump].arg = out.codeLen;   // JZ → 거짓 분기 시작
+        }
+        f.jump = out.codeLen - 1;
+        f.hooks = f.next;
+        sp--;  // 조건 pop (또는 참 분기 결과 자리를 거짓 분기가 대신함)
+      }
+
+      // 자식 먼저
+      if (f.next < 3 && n.kids[f.next] != NONE) {
+        uint8_t child = n.kids[f.next++];
+        if (top + 1 > EXPR_MAX_DEPTH) return _fail("nested too deeply", 0);
+        stack[++top].node = child;
+        stack[top].next = 0;
+        stack[top].hooks = 0;
+        if (top + 1 > out.depth) out.depth = (uint8_t)(top + 1);
+        continue;
+      }
+
+      if (n.op == OP_SELECT) {
+        out.code[f.jump].arg = out.codeLen;              // JMP → 끝
+      } else if (lazy) {
+        if (!_emitOp(OP_BOOL, 0, out, n)) return false;
+        out.code[f.jump].arg = out.codeLen;              // JZ_KEEP/JNZ_KEEP → 끝
+      } else {
+        uint8_t arg = n.arg;
+        if (n.op == OP_CONST) {
+          arg = _constIndex(n.value, out);
+          if (arg == NONE) return _fail("too many constants", 0);
+        }
+        if (!_emitOp(n.op, arg, out, n)) return false;
+
+        // 스택 깊이 추적
+        if (n.kids[0] == NONE) sp++;         // 피연산자
+        else if (n.kids[2] != NONE) sp -= 2; // 3항 (noise3)
+        else if (n.kids[1] != NONE) sp--;    // 이항
+      }
+      if (sp > EXPR_STACK_SIZE) return _fail("expression needs too much stack", 0);
+      if (sp > out.maxStack) out.maxStack = (uint8_t)sp;
+
+      top--;
+    }
+    return true;
+  }
+};
+
+// 수식 결과(h, s, v) → 8비트 HSV 정규화
+// h: 라디안(0~2π 순환), s: 0~1, v: |v| 0~1
+struct HsvBytes {
+  uint8_t h, s, v;
+};
+
+inline HsvBytes normalizeHsv(float h, float s, float v) {
+  h = fmod(h, 2 * VIBE_PI);
+  if (h < 0) h += 2 * VIBE_PI;
+
+  s = (s < 0.0f) ? 0.0f : (s > 1.0f ? 1.0f : s);
+  v = fabs(v);
+  v = (v > 1.0f) ? 1.0f : v;
+
+  HsvBytes out;
+  out.h = (uint8_t)((h / (2 * VIBE_PI)) * 255);
+  out.s = (uint8_t)(s * 255);
+  out.v = (uint8_t)(v * 255);
+  return out;
+}
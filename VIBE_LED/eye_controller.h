@@ -14,6 +14,9 @@
 #ifndef NUM_LEDS
 #define NUM_LEDS    12
 #endif
+#ifndef LED_TOP_INDEX
+#define LED_TOP_INDEX 3   // 기본 링의 맨 위 LED 인덱스 (눈꺼풀 방향 기준)
+#endif
 #ifndef LED_TYPE
 #define LED_TYPE    WS2812B
 #endif
@@ -24,13 +27,38 @@
 #ifndef BUTTON_PIN
 #define BUTTON_PIN  9
 #endif
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 25   // 엣지 디바운스 (ms)
+#endif
+#ifndef BUTTON_LONG_PRESS_MS
+#define BUTTON_LONG_PRESS_MS 1000
+#endif
+#ifndef EYE_MAX_CONTROLLERS
+#define EYE_MAX_CONTROLLERS 4   // 독립 LED 컨트롤러(링) 최대 개수
+#endif
+static_assert(EYE_MAX_CONTROLLERS >= 1 && EYE_MAX_CONTROLLERS <= 255, "EYE_MAX_CONTROLLERS must be 1..255");
+// 두 번째 링 (선택): LED2_PIN을 정의하면 "eye2" 컨트롤러가 추가된다
+#ifdef LED2_PIN
+  #ifndef LED2_NUM_LEDS
+  #define LED2_NUM_LEDS NUM_LEDS
+  #endif
+  #ifndef LED2_TOP_INDEX
+  #define LED2_TOP_INDEX LED_TOP_INDEX
+  #endif
+  static_assert(EYE_MAX_CONTROLLERS >= 2, "LED2_PIN needs EYE_MAX_CONTROLLERS >= 2");
+#endif
+#ifndef EYE_TASK_STACK
+// 수식 실행은 비재귀(고정 값 스택)이지만, 최악 패턴으로 실측하기 전까지는 기존 크기를 유지
+// (줄이기 전에 slot_status의 render_stack_free로 여유를 확인)
+#define EYE_TASK_STACK 4096
+#endif
 #define POWER_LED_PIN 10
 #define MCP_LED_PIN 4
 #define POWER_LED_BRIGHTNESS 20 // 파워 LED 밝기 조절 (0~255)
 
-// 전역 LED 버퍼
-static CRGB leds[NUM_LEDS];
-
+// 눈 LED 컨트롤러
+// 링(핀 + LED 수)마다 하나씩 존재하며 각자 버퍼, 기하 정보, 패턴 재생 상태, 프레임 주기를 가진다.
+// 버튼/전원/렌더 태스크는 모든 컨트롤러가 공유한다.
 class EyeController {
 public:
   enum class Mood : uint8_t { Neutral, Annoyed, Angry };
@@ -43,8 +71,8 @@ public:
     uint16_t closeMs       = 140;   // 감기
     uint16_t holdMs        =  80;   // 유지
     uint16_t openMs        = 160;   // 뜨기
-    uint8_t  baseBrightness= 100;   // 기본 밝기
-    uint16_t tickMs        = 16;    // 태스크 주기(~60fps)
+    uint8_t  baseBrightness= 100;   // 기본 밝기 (FastLED 전역, 기본 링의 값을 begin()에서 적용)
+    uint16_t tickMs        = 16;    // 프레임 주기(~60fps), 컨트롤러별
 
     // 연출 옵션
     bool     eyelidSweep   = true;  // true면 눈꺼풀 스윕 사용
@@ -59,20 +87,53 @@ public:
 
   DynamicPattern dynamicPattern;
 
+  // 기본 링 (LED_PIN, NUM_LEDS, LED_TOP_INDEX)
+  // 다른 링보다 항상 먼저 등록되므로(addRing 참고) 자리가 모자라 실패하는 일이 없다.
   static EyeController& instance() {
-    static EyeController inst;
+    static EyeController& inst = *_ring<LED_PIN, NUM_LEDS>("main", LED_TOP_INDEX);
     return inst;
   }
 
+  // 추가 링 등록: 버퍼와 기하 테이블, 커널 테이블을 (PIN, N)에 대해 정적으로 생성한다.
+  // 같은 (PIN, N)으로 다시 호출하면 기존 컨트롤러를 반환한다.
+  // begin() 전에만 새 링을 등록할 수 있다. 렌더 태스크는 잠금 없이 컨트롤러 목록과 FastLED의
+  // 컨트롤러 목록을 순회하므로, 태스크가 시작된 뒤에는 목록을 바꾸지 않는다.
+  // 반환: 컨트롤러, 자리가 없거나(EYE_MAX_CONTROLLERS) begin() 이후면 nullptr (FastLED에도 추가하지 않음)
+  template <uint8_t PIN, uint16_t N>
+  static EyeController* addRing(const char* name, uint8_t topIndex) {
+    instance();  // 기본 링이 첫 자리를 차지하도록
+    return _ring<PIN, N>(name, topIndex);
+  }
+
+  // 이름으로 컨트롤러 조회 (null 또는 ""이면 기본 링, 없으면 nullptr)
+  static EyeController* find(const char* target) {
+    if (!target || !*target) return &instance();
+    Shared& sh = _shared();
+    for (uint8_t i = 0; i < sh.count; i++) {
+      if (strcmp(sh.controllers[i]->_name, target) == 0) return sh.controllers[i];
+    }
+    return nullptr;
+  }
+
+  static uint8_t count() { return _shared().count; }
+  static EyeController* at(uint8_t i) { return i < _shared().count ? _shared().controllers[i] : nullptr; }
+
+  const char* name() const { return _name; }
+  uint16_t numLeds() const { return _numLeds; }
+
   // MCP 연결 상태 LED 제어
   void setMCPStatus(bool connected) {
     digitalWrite(MCP_LED_PIN, connected ? HIGH : LOW);
   }
 
+  // 공유 자원(버튼, 상태 LED, 패턴 라이브러리)과 등록된 모든 링 초기화
   void begin() {
-    if (_inited) return;
-    
+    Shared& sh = _shared();
+    if (sh.inited) return;
+
     pinMode(BUTTON_PIN, INPUT_PULLUP); // 버튼 핀 초기화
+    sh.btnDown = (digitalRead(BUTTON_PIN) == LOW);
+    attachInterruptArg(digitalPinToInterrupt(BUTTON_PIN), &_onButtonIsr, &sh, CHANGE);
 
     // 상태 LED 초기화
     pinMode(POWER_LED_PIN, OUTPUT);
@@ -81,71 +142,59 @@ public:
     digitalWrite(MCP_LED_PIN, LOW);    // MCP 연결 대기
 
     // NVS 로드 및 패턴 시스템 초기화
-    dynamicPattern.begin();
+    PatternLibrary::instance().begin();
 
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-    FastLED.setBrightness(cfg.baseBrightness);
-    FastLED.clear(true);
-    setMood(Mood::Neutral, /*immediateShow=*/true);
+    instance();
+#ifdef LED2_PIN
+    addRing<LED2_PIN, LED2_NUM_LEDS>("eye2", LED2_TOP_INDEX);
+#endif
 
     randomSeed((uint32_t)micros());
-    _scheduleNextBlink(millis(), /*immediate=*/false);
-    _inited = true;
+    FastLED.setBrightness(cfg.baseBrightness);
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < sh.count; i++) sh.controllers[i]->_beginRing(now);
+    FastLED.show();
+    sh.inited = true;
     _startBackgroundTask();
   }
 
-  void update() {
-    if (!_inited) return;
+  // 렌더 루프 한 번: 버튼 처리 후 프레임 시각이 된 컨트롤러만 렌더링하고,
+  // 하나라도 렌더링했으면 FastLED.show() 한 번으로 모든 링을 함께 전송한다.
+  // (ESP32 RMT 드라이버는 컨트롤러들을 묶어 마지막 컨트롤러가 시작될 때 전송하므로
+  //  링별 showLeds()는 링 타이밍을 서로 묶어 버린다)
+  // 반환: 다음 프레임까지 남은 시간 (ms)
+  static uint32_t runOnce() {
+    Shared& sh = _shared();
+    if (!sh.inited) return 0;
     const uint32_t now = millis();
 
-    // --- 버튼 폴링 로직 (Short/Long Press) ---
-    bool btnState = digitalRead(BUTTON_PIN);
-    
-    // 버튼 눌림 (Falling Edge)
-    if (btnState == LOW && _lastBtnState == HIGH) {
-      _btnPressTime = now;
-      _longPressTriggered = false;
-    }
-    
-    // 버튼 누르고 있는 중
-    if (btnState == LOW) {
-      // 1초 이상 누르면 롱프레스 처리 (한 번만) - 전원 토글
-      if (!_longPressTriggered && (now - _btnPressTime > 1000)) {
-        _longPressTriggered = true;
-        
-        _powerOn = !_powerOn; // 전원 상태 토글
-
-        if (_powerOn) {
-          // 전원 켜짐
-          // analogWrite(POWER_LED_PIN, POWER_LED_BRIGHTNESS); // 이미 켜져있으므로 생략 가능하나 명시적으로 유지
-        } else {
-          // 전원 꺼짐 (Sleep Mode) - 눈만 끔, 파워 LED는 유지
-          // analogWrite(POWER_LED_PIN, 0); // <--- 제거됨: 파워 LED는 켜둔 상태 유지
-          dynamicPattern.stop(); 
-          FastLED.clear(true);
-        }
-      }
-    }
-
-    // 버튼 뗌 (Rising Edge)
-    if (btnState == HIGH && _lastBtnState == LOW) {
-      // 롱프레스가 아니었다면 숏프레스 처리 (디바운스 50ms 고려)
-      if (!_longPressTriggered && (now - _btnPressTime > 50)) {
-        if (_powerOn) {
-           dynamicPattern.cycleNextSlot(); // 전원 켜져있을 때만 패턴 변경
+    // --- 버튼 이벤트 처리 (ISR 큐 소비) ---
+    _processButton(now);
+
+    uint32_t wait = 0xFFFF;
+    bool rendered = false;
+    for (uint8_t i = 0; i < sh.count; i++) {
+      EyeController* c = sh.controllers[i];
+      if ((int32_t)(now - c->_nextFrameMs) >= 0) {
+        // 전원 꺼져있으면 LED 렌더링 중단
+        if (sh.powerOn) {
+          c->update(now);
+          rendered = true;
         }
+        c->_nextFrameMs = now + c->cfg.tickMs;
       }
+      uint32_t left = c->_nextFrameMs - now;
+      if (left < wait) wait = left;
     }
-    
-    _lastBtnState = btnState;
-    // --- 버튼 폴링 로직 끝 ---
-
-    if (!_powerOn) return; // 전원 꺼져있으면 여기서 리턴 (LED 렌더링 중단)
+    if (rendered) FastLED.show();
+    return wait;
+  }
 
+  // 이 컨트롤러의 프레임 하나를 버퍼에 렌더링 (전송은 runOnce()가 모아서 한 번)
+  void update(uint32_t now) {
     // 동적 패턴 우선 처리
     if (dynamicPattern.isActive()) {
-      dynamicPattern.update(leds, now);
-      FastLED.show();
+      dynamicPattern.update(_leds, now);
       return;
     }
 
@@ -206,10 +255,60 @@ public:
 
   Mood currentMood() const { return _mood; }
 
+  // 렌더 태스크 스택 최소 여유량 (bytes, 태스크 시작 전이면 0)
+  static uint32_t stackHighWaterMark() {
+#if defined(ESP32)
+    if (_shared().taskHandle) return uxTaskGetStackHighWaterMark(_shared().taskHandle);
+#endif
+    return 0;
+  }
+
 private:
-  EyeController() {}
-  bool _inited = false;
-  bool _powerOn = true; // 전원 상태 추적
+  // 버튼 관련
+  // ISR이 엣지를 타임스탬프와 함께 큐에 넣고, 렌더 태스크가 소비한다.
+  // 따라서 프레임 비용과 무관하게 누름/뗌 시각이 정확하다.
+  struct ButtonEvent {
+    uint32_t ms;
+    bool     pressed;
+  };
+  static constexpr uint8_t BTN_QUEUE_LEN = 8; // 2의 거듭제곱
+
+  // 모든 컨트롤러가 공유하는 상태
+  struct Shared {
+    EyeController* controllers[EYE_MAX_CONTROLLERS] = {};
+    uint8_t  count = 0;
+    bool     inited = false;
+    bool     powerOn = true; // 전원 상태 추적
+
+    ButtonEvent       btnQueue[BTN_QUEUE_LEN];
+    volatile uint8_t  btnHead = 0;   // ISR 쓰기 위치
+    volatile uint8_t  btnTail = 0;   // 태스크 읽기 위치
+    volatile uint32_t btnIsrLastMs = 0;
+
+    bool     btnDown = false;
+    uint32_t btnPressTime = 0;
+    uint32_t btnLastEventMs = 0;
+    bool     longPressTriggered = false;
+
+#if defined(ESP32)
+    TaskHandle_t taskHandle = nullptr;
+#endif
+  };
+
+  static Shared& _shared() {
+    static Shared sh;
+    return sh;
+  }
+
+  EyeController(const char* name, CRGB* leds, uint16_t numLeds, const float* heights)
+    : _name(name), _leds(leds), _numLeds(numLeds), _heights(heights) {}
+
+  const char*     _name;
+  CRGB*           _leds;
+  uint16_t        _numLeds;
+  const float*    _heights;             // RingGeometry<N>::lidHeights()
+  CLEDController* _led = nullptr;
+  uint32_t        _nextFrameMs = 0;
 
   Mood _mood = Mood::Neutral;
   CRGB _color = CRGB(0, 255, 0);
@@ -218,11 +317,126 @@ private:
   uint32_t _phaseStart = 0;
   uint32_t _nextDue    = 0;
   bool     _pendingDouble = false;
-  
-  // 버튼 관련 멤버
-  bool     _lastBtnState = HIGH;
-  uint32_t _btnPressTime = 0;
-  bool     _longPressTriggered = false;
+
+  template <uint8_t PIN, uint16_t N>
+  static EyeController* _ring(const char* name, uint8_t topIndex) {
+    static CRGB buffer[N];
+    static uint8_t streamStorage[3 * 3 * N];  // FrameStream 트리플 버퍼
+    static CRGB fadeBuffer[N];                // 슬롯 전환 크로스페이드용 직전 화면
+    static EyeController inst(name, buffer, N, RingGeometry<N>::lidHeights());
+    if (inst._led) return &inst;
+
+    // 자리가 없거나 렌더 태스크가 이미 돌고 있으면 FastLED에 붙이기 전에 거절
+    // (전송만 되고 렌더링되지 않는 링이나, 렌더 루프와 경쟁하는 목록 쓰기가 생기지 않도록)
+    Shared& sh = _shared();
+    if (sh.inited) {
+      Serial.printf("[EYE] Ring '%s' must be added before begin(), not added\n", name);
+      return nullptr;
+    }
+    if (sh.count >= EYE_MAX_CONTROLLERS) {
+      Serial.printf("[EYE] Too many rings (EYE_MAX_CONTROLLERS=%d), '%s' not added\n", EYE_MAX_CONTROLLERS, name);
+      return nullptr;
+    }
+    inst.cfg.topIndex = topIndex;
+    inst.dynamicPattern.attach(N, NativeKernels<N>::table(), streamStorage, fadeBuffer);
+    inst._led = &FastLED.addLeds<LED_TYPE, PIN, COLOR_ORDER>(buffer, N);
+    sh.controllers[sh.count++] = &inst;   // begin()이 _beginRing()으로 초기화한다
+    return &inst;
+  }
+
+  void _beginRing(uint32_t now) {
+    for (uint16_t i = 0; i < _numLeds; i++) _leds[i] = CRGB::Black;
+    setMood(Mood::Neutral, /*immediateShow=*/true);
+    _scheduleNextBlink(now, /*immediate=*/false);
+    _nextFrameMs = now;
+  }
+
+  static void IRAM_ATTR _onButtonIsr(void* arg) {
+    Shared* sh = static_cast<Shared*>(arg);
+    const uint32_t ms = millis();
+    // 디바운스: 직전 수락 엣지로부터 BUTTON_DEBOUNCE_MS 이내 엣지는 무시
+    if (ms - sh->btnIsrLastMs < BUTTON_DEBOUNCE_MS) return;
+    sh->btnIsrLastMs = ms;
+
+    uint8_t head = sh->btnHead;
+    uint8_t next = (head + 1) & (BTN_QUEUE_LEN - 1);
+    if (next == sh->btnTail) return; // 큐 가득 참: 이벤트 버림
+    sh->btnQueue[head].ms = ms;
+    sh->btnQueue[head].pressed = (digitalRead(BUTTON_PIN) == LOW);
+    sh->btnHead = next;
+
+#if defined(ESP32)
+    // 렌더 태스크를 즉시 깨워 tickMs 대기 없이 반응
+    if (sh->taskHandle) {
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(sh->taskHandle, &woken);
+      portYIELD_FROM_ISR(woken);
+    }
+#endif
+  }
+
+  static void _processButton(uint32_t now) {
+    Shared& sh = _shared();
+    // 큐에 쌓인 엣지를 시간 순서대로 처리
+    while (sh.btnTail != sh.btnHead) {
+      ButtonEvent ev = sh.btnQueue[sh.btnTail];
+      sh.btnTail = (sh.btnTail + 1) & (BTN_QUEUE_LEN - 1);
+      _handleButtonEdge(ev.pressed, ev.ms);
+    }
+
+    // 디바운스 창 안에서 뗀 짧은 탭 등, 놓친 엣지 보정
+    bool level = (digitalRead(BUTTON_PIN) == LOW);
+    if (level != sh.btnDown && (int32_t)(now - sh.btnLastEventMs) >= BUTTON_DEBOUNCE_MS) {
+      _handleButtonEdge(level, now);
+    }
+
+    // 누르고 있는 중: 롱프레스 처리 (한 번만) - 전원 토글
+    if (sh.btnDown && !sh.longPressTriggered && (int32_t)(now - sh.btnPressTime) >= BUTTON_LONG_PRESS_MS) {
+      sh.longPressTriggered = true;
+      _togglePower();
+    }
+  }
+
+  static void _handleButtonEdge(bool pressed, uint32_t ms) {
+    Shared& sh = _shared();
+    sh.btnLastEventMs = ms;
+    if (pressed == sh.btnDown) return; // 상태 변화 없음 (중복 엣지)
+    sh.btnDown = pressed;
+
+    // 버튼 눌림 (Falling Edge)
+    if (pressed) {
+      sh.btnPressTime = ms;
+      sh.longPressTriggered = false;
+      return;
+    }
+
+    // 버튼 뗌 (Rising Edge) - 누른 시간은 이벤트 타임스탬프로 계산
+    uint32_t held = ms - sh.btnPressTime;
+    if (sh.longPressTriggered) return;
+    if (held >= BUTTON_LONG_PRESS_MS) {
+      // 프레임이 길어 누르는 동안 롱프레스를 못 본 경우
+      sh.longPressTriggered = true;
+      _togglePower();
+    } else if (sh.powerOn) {
+      // 전원 켜져있을 때만 패턴 변경 (모든 링)
+      for (uint8_t i = 0; i < sh.count; i++) sh.controllers[i]->dynamicPattern.cycleNextSlot();
+    }
+  }
+
+  static void _togglePower() {
+    Shared& sh = _shared();
+    sh.powerOn = !sh.powerOn; // 전원 상태 토글
+
+    if (!sh.powerOn) {
+      // 전원 꺼짐 (Sleep Mode) - 눈만 끔, 파워 LED는 유지
+      for (uint8_t i = 0; i < sh.count; i++) {
+        EyeController* c = sh.controllers[i];
+        c->dynamicPattern.stop();
+        for (uint16_t k = 0; k < c->_numLeds; k++) c->_leds[k] = CRGB::Black;
+      }
+      FastLED.show();
+    }
+  }
 
   void _cycleMood() {
     switch (_mood) {
@@ -232,10 +446,6 @@ private:
     }
   }
 
-#if defined(ESP32)
-  TaskHandle_t _taskHandle = nullptr;
-#endif
-
   void _startPhase(BlinkPhase p, uint32_t now) { _phase = p; _phaseStart = now; }
 
   void _scheduleNextBlink(uint32_t now, bool immediate) {
@@ -270,8 +480,7 @@ private:
   void _renderByPhase(uint8_t scale) {
     if (!cfg.eyelidSweep) {
       CRGB c = _color; c.nscale8_video(scale);
-      fill_solid(leds, NUM_LEDS, c);
-      FastLED.show();
+      fill_solid(_leds, _numLeds, c);
       return;
     }
     float openRatio = scale / 255.0f;
@@ -282,14 +491,16 @@ private:
     const float low  = (1.0f - openRatio) * 0.5f;
     const float high = 1.0f - low;
 
-    const float feather = (cfg.featherLEDs > 0) ? (float)cfg.featherLEDs / (float)NUM_LEDS : 0.0f;
+    const float feather = (cfg.featherLEDs > 0) ? (float)cfg.featherLEDs / (float)_numLeds : 0.0f;
+
+    // LED별 높이는 N에 특수화된 테이블에서 조회 (프레임마다 cos 계산 안 함)
+    const float* heights = _heights;
 
-    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+    for (uint16_t i = 0; i < _numLeds; ++i) {
       int16_t di = (int16_t)i - (int16_t)cfg.topIndex;
-      di %= (int16_t)NUM_LEDS; if (di < 0) di += NUM_LEDS;
-      float theta = (2.0f * PI) * ((float)di / (float)NUM_LEDS);
+      di %= (int16_t)_numLeds; if (di < 0) di += _numLeds;
 
-      float h = (cosf(theta) + 1.0f) * 0.5f;
+      float h = heights[di];
 
       float lit = 0.0f;
       if (h >= (low + feather) && h <= (high - feather)) {
@@ -309,23 +520,27 @@ private:
 
       CRGB c = _color;
       c.nscale8_video((uint8_t)(lit * 255.0f));
-      leds[i] = c;
+      _leds[i] = c;
     }
-    FastLED.show();
   }
 
-  static void _taskLoop(void* pv) {
-    EyeController* self = static_cast<EyeController*>(pv);
+#if defined(ESP32)
+  // 단일 렌더 태스크: 각 링을 자신의 tickMs 주기로 렌더링하고,
+  // 가장 빠른 다음 프레임 시각까지 대기 (버튼 ISR 알림이 오면 즉시 깨어남)
+  // 호스트 빌드(host/stress_tools)는 같은 루프를 스레드로 돌린다.
+  static void _taskLoop(void*) {
     for (;;) {
-      self->update();
-      vTaskDelay(pdMS_TO_TICKS(self->cfg.tickMs));
+      uint32_t wait = runOnce();
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait ? wait : 1));
     }
   }
+#endif
 
-  void _startBackgroundTask() {
+  static void _startBackgroundTask() {
 #if defined(ESP32)
-    if (_taskHandle) return;
-    xTaskCreate(&_taskLoop, "EyeBlinkTask", 4096, this, 1, &_taskHandle);
+    Shared& sh = _shared();
+    if (sh.taskHandle) return;
+    xTaskCreate(&_taskLoop, "EyeBlinkTask", EYE_TASK_STACK, nullptr, 1, &sh.taskHandle);
 #endif
   }
-};
\ No newline at end of file
+};
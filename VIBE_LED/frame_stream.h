@@ -0,0 +1,128 @@
+#pragma once
+#include <Arduino.h>
+#include <FastLED.h>
+#include <atomic>
+#include <mutex>
+
+// 원시 프레임 스트리밍 (Slot 7)
+// 호스트가 계산한 RGB 프레임을 수식 엔진 없이 그대로 표시한다.
+// 버퍼 저장소(3 * LED 수 * 3 바이트)는 LED 컨트롤러가 정적으로 할당해 attach()로 넘긴다.
+//
+// 트리플 버퍼 구조:
+//   - 쓰기 측(툴 태스크)은 back 버퍼에 바로 디코딩한 뒤 middle과 교환
+//   - 읽기 측(렌더 태스크)은 새 프레임이 있을 때만 middle과 front를 교환
+// 읽기 측에는 락이 없고, 표시 전에 덮어써진 프레임은 버려진다 (Latest-frame-wins).
+// 쓰기 측끼리는 (툴 호출이 동시에 들어올 때를 위해) 짧은 잠금으로 직렬화한다.
+class FrameStream {
+public:
+  static_assert(sizeof(CRGB) == 3, "CRGB must be packed RGB");
+
+  // 카운터마다 쓰는 쪽은 하나(쓰기 측 또는 렌더 태스크)이고 툴 응답이 언제든 읽으므로 atomic
+  struct Stats {
+    std::atomic<uint32_t> received{0};   // 검증 통과한 프레임
+    std::atomic<uint32_t> shown{0};      // 실제로 표시된 프레임
+    std::atomic<uint32_t> dropped{0};    // 표시 전에 새 프레임으로 덮어써짐
+    std::atomic<uint32_t> invalid{0};    // 길이/인코딩 오류
+    std::atomic<uint32_t> lastLatencyUs{0}; // 수신 → 표시 지연
+    std::atomic<uint32_t> maxLatencyUs{0};
+    std::atomic<uint32_t> avgLatencyUs{0};  // 지수 이동 평균 (1/8)
+  };
+
+  // storage: 3 * frameBytes 바이트
+  void attach(uint8_t* storage, size_t frameBytes) {
+    _storage = storage;
+    _frameBytes = frameBytes;
+  }
+
+  size_t frameBytes() const { return _frameBytes; }
+
+  // base64 RGB 페이로드를 back 버퍼에 직접 디코딩 후 게시
+  // 반환: false = 길이 불일치 또는 잘못된 인코딩
+  bool pushBase64(const char* b64, uint32_t recvUs) {
+    if (!_storage) return false;
+    std::lock_guard<std::mutex> lock(_writeMutex);
+    uint8_t* dst = _buf(_back);
+    size_t n = _decodeBase64(b64, dst, _frameBytes);
+    if (n != _frameBytes) {
+      _stats.invalid++;
+      return false;
+    }
+    _publish(recvUs);
+    return true;
+  }
+
+  // 렌더 태스크: 새 프레임이 있으면 leds로 복사 (없으면 이전 프레임 유지)
+  bool latch(CRGB* leds, uint32_t nowUs) {
+    if (!(_middle.load(std::memory_order_acquire) & FRESH)) return false;
+
+    uint8_t prev = _middle.exchange(_front, std::memory_order_acq_rel);
+    _front = prev & INDEX_MASK;
+    memcpy(leds, _buf(_front), _frameBytes);
+
+    uint32_t lat = nowUs - _stampUs[_front];
+    uint32_t avg = _stats.avgLatencyUs;
+    _stats.shown++;
+    _stats.lastLatencyUs = lat;
+    if (lat > _stats.maxLatencyUs) _stats.maxLatencyUs = lat;
+    _stats.avgLatencyUs = (avg == 0) ? lat : avg - (avg >> 3) + (lat >> 3);
+    return true;
+  }
+
+  // 렌더 태스크: 마지막으로 표시한 프레임을 다시 복사 (leds를 다른 용도로 덮어쓴 경우)
+  void copyFront(CRGB* leds) const { memcpy(leds, _buf(_front), _frameBytes); }
+
+  const Stats& stats() const { return _stats; }
+
+private:
+  static constexpr uint8_t FRESH = 0x80;
+  static constexpr uint8_t INDEX_MASK = 0x03;
+
+  uint8_t* _storage = nullptr;
+  size_t   _frameBytes = 0;
+  uint32_t _stampUs[3] = {};
+  uint8_t  _back = 0;                 // 쓰기 측 전용 (_writeMutex)
+  uint8_t  _front = 2;                // 읽기 측 전용
+  std::atomic<uint8_t> _middle{1};    // 공유 (FRESH 비트 = 미표시 프레임 있음)
+  Stats    _stats;
+  std::mutex _writeMutex;             // 쓰기 측끼리만 (렌더 태스크는 잡지 않음)
+
+  uint8_t* _buf(uint8_t k) const { return _storage + k * _frameBytes; }
+
+  void _publish(uint32_t recvUs) {
+    _stampUs[_back] = recvUs;
+    uint8_t prev = _middle.exchange(_back | FRESH, std::memory_order_acq_rel);
+    if (prev & FRESH) _stats.dropped++; // 표시되지 못한 프레임을 덮어씀
+    _back = prev & INDEX_MASK;
+    _stats.received++;
+  }
+
+  static int8_t _b64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+  }
+
+  // 반환: 디코딩된 바이트 수 (cap 초과 또는 잘못된 문자면 0, 공백/줄바꿈은 건너뜀)
+  static size_t _decodeBase64(const char* in, uint8_t* out, size_t cap) {
+    if (!in) return 0;
+    size_t n = 0;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (const char* p = in; *p && *p != '='; p++) {
+      if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') continue;  // MIME식 줄바꿈 허용
+      int8_t v = _b64Value(*p);
+      if (v < 0) return 0;
+      acc = (acc << 6) | (uint32_t)v;
+      bits += 6;
+      if (bits >= 8) {
+        bits -= 8;
+        if (n >= cap) return 0;
+        out[n++] = (uint8_t)(acc >> bits);
+      }
+    }
+    return n;
+  }
+};
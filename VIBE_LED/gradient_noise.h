@@ -0,0 +1,98 @@
+#pragma once
+// 정수 그래디언트 노이즈 (Perlin improved noise, FastLED inoise16 방식)
+// 플랫폼 독립: Arduino/FastLED 의존성이 없어 호스트 도구에서도 같은 값을 낸다.
+//
+// 좌표는 Q16.16 고정소수점이고 격자 간격은 1.0 (정수 부분 하위 8비트만 쓰므로 256 단위로 반복).
+// 순열 해시, 5차 페이드, 보간이 모두 정수 연산이라 LED마다 libm 호출이 없다.
+#include <stdint.h>
+#include <math.h>
+
+struct GradientNoise {
+  // 반환: Q16 (대략 ±65536 = ±1.0)
+  static int32_t noise1(uint32_t x) {
+    uint8_t X = (uint8_t)(x >> 16);
+    int32_t fx = (int32_t)(x & 0xFFFF);
+    int32_t u = _fade(fx);
+    int32_t a = _grad1(_p(X), fx);
+    int32_t b = _grad1(_p((uint8_t)(X + 1)), fx - 0x10000);
+    return _lerp(a, b, u);
+  }
+
+  static int32_t noise2(uint32_t x, uint32_t y) {
+    uint8_t X = (uint8_t)(x >> 16), Y = (uint8_t)(y >> 16);
+    int32_t fx = (int32_t)(x & 0xFFFF), fy = (int32_t)(y & 0xFFFF);
+    int32_t u = _fade(fx), v = _fade(fy);
+    uint8_t A = _p(X) + Y, B = _p((uint8_t)(X + 1)) + Y;
+    int32_t x1 = fx - 0x10000, y1 = fy - 0x10000;
+    int32_t lo = _lerp(_grad3(_p(A), fx, fy, 0), _grad3(_p(B), x1, fy, 0), u);
+    int32_t hi = _lerp(_grad3(_p((uint8_t)(A + 1)), fx, y1, 0), _grad3(_p((uint8_t)(B + 1)), x1, y1, 0), u);
+    return _lerp(lo, hi, v);
+  }
+
+  static int32_t noise3(uint32_t x, uint32_t y, uint32_t z) {
+    uint8_t X = (uint8_t)(x >> 16), Y = (uint8_t)(y >> 16), Z = (uint8_t)(z >> 16);
+    int32_t fx = (int32_t)(x & 0xFFFF), fy = (int32_t)(y & 0xFFFF), fz = (int32_t)(z & 0xFFFF);
+    int32_t u = _fade(fx), v = _fade(fy), w = _fade(fz);
+    uint8_t A = _p(X) + Y, AA = _p(A) + Z, AB = _p((uint8_t)(A + 1)) + Z;
+    uint8_t B = _p((uint8_t)(X + 1)) + Y, BA = _p(B) + Z, BB = _p((uint8_t)(B + 1)) + Z;
+    int32_t x1 = fx - 0x10000, y1 = fy - 0x10000, z1 = fz - 0x10000;
+
+    int32_t n0 = _lerp(_lerp(_grad3(_p(AA), fx, fy, fz), _grad3(_p(BA), x1, fy, fz), u),
+                       _lerp(_grad3(_p(AB), fx, y1, fz), _grad3(_p(BB), x1, y1, fz), u), v);
+    int32_t n1 = _lerp(_lerp(_grad3(_p((uint8_t)(AA + 1)), fx, fy, z1), _grad3(_p((uint8_t)(BA + 1)), x1, fy, z1), u),
+                       _lerp(_grad3(_p((uint8_t)(AB + 1)), fx, y1, z1), _grad3(_p((uint8_t)(BB + 1)), x1, y1, z1), u), v);
+    return _lerp(n0, n1, w);
+  }
+
+  // float 좌표 → Q16.16. 256 주기로 먼저 감아서 t가 커져도 넘치지 않는다.
+  // NaN/inf(예: noise1(sqrt(-1)))는 정수 변환이 정의되지 않으므로 0으로 둔다.
+  // 유한한 값은 감은 뒤 [0, 256] 범위라 변환 결과가 2^24 이하.
+  static uint32_t fixed(float v) {
+    if (!isfinite(v)) return 0;
+    v -= 256.0f * floorf(v * (1.0f / 256.0f));
+    return (uint32_t)(v * 65536.0f);
+  }
+
+private:
+  static uint8_t _p(uint8_t k) {
+    // Ken Perlin 참조 구현의 순열
+    static const uint8_t kPerm[256] = {
+      151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,8,99,37,240,21,10,23,
+      190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,57,177,33,88,237,149,56,87,174,20,
+      125,136,171,168,68,175,74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,
+      105,92,41,55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,200,196,
+      135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,250,124,123,5,202,38,147,118,126,255,
+      82,85,212,207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,
+      153,101,155,167,43,172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,228,
+      251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,107,49,192,214,31,181,199,
+      106,157,184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,222,114,67,29,24,72,243,141,128,
+      195,78,66,215,61,156,180,
+    };
+    return kPerm[k];
+  }
+
+  // 6t^5 - 15t^4 + 10t^3 (Q16)
+  static int32_t _fade(int32_t t) {
+    int64_t t3 = (((int64_t)t * t) >> 16) * t >> 16;
+    int64_t q = (((int64_t)t * (t * 6 - (15 << 16))) >> 16) + (10 << 16);
+    return (int32_t)((t3 * q) >> 16);
+  }
+
+  static int32_t _lerp(int32_t a, int32_t b, int32_t u) {
+    return a + (int32_t)(((int64_t)(b - a) * u) >> 16);
+  }
+
+  // 1D: 기울기 ±1/4 ~ ±2
+  static int32_t _grad1(uint8_t h, int32_t x) {
+    int32_t g = x * ((h & 7) + 1) >> 2;
+    return (h & 8) ? -g : g;
+  }
+
+  // 3D: 정육면체 모서리 방향 12개 (+4 중복), 2D는 z = 0
+  static int32_t _grad3(uint8_t h, int32_t x, int32_t y, int32_t z) {
+    h &= 15;
+    int32_t u = (h < 8) ? x : y;
+    int32_t v = (h < 4) ? y : (h == 12 || h == 14) ? x : z;
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+  }
+};
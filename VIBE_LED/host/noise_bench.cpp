@@ -0,0 +1,166 @@
+// 노이즈 함수 벤치마크 (호스트/Linux 전용 CLI)
+//
+// "유기적인" 움직임을 만드는 두 방법의 LED당 비용을 같은 ExpressionEvaluator 코드로 비교한다.
+//   - sine-sum: 주파수가 다른 sin 항 여러 개를 더한 수식 (Bio Rhythm 방식)
+//   - noise   : noise1/noise2/noise3 한 번 호출
+// 앞부분은 커널 단독(sinf 대비 noise 호출 비용)을, 뒷부분은 DynamicPattern::update와 같은
+// 프레임 루프로 수식 전체를 실행한 LED당 평균 시간을 출력한다.
+//
+// 빌드:
+//   g++ -std=c++17 -O2 -I.. noise_bench.cpp -o noise_bench
+//
+// 사용 예:
+//   ./noise_bench                    # 12 LED, 20000 프레임
+//   ./noise_bench --leds 24 --frames 50000
+//
+// 참고: 호스트 CPU의 sinf는 ESP32보다 훨씬 빠르므로 절대값보다 비율을 본다.
+// 노이즈 커널은 libm 없이 정수 연산과 테이블 조회만 쓴다.
+
+#ifndef ARDUINO   // 모듈 폴더째 펌웨어 빌드에 포함되어도 무시되도록
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+
+#include "expression_evaluator.h"
+
+float port_get_inport_value(const char*) {
+  return NAN;
+}
+
+static volatile float g_sink;   // 결과를 버리지 않도록 (최적화 방지)
+
+static double nowSec() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===== 커널 단독 =====
+static void benchKernels(long calls) {
+  printf("%-28s %10s\n", "kernel", "ns/call");
+
+  float acc = 0;
+  double t0 = nowSec();
+  for (long k = 0; k < calls; k++) acc += sinf(k * 0.001f);
+  double sinNs = (nowSec() - t0) * 1e9 / calls;
+  printf("%-28s %10.2f\n", "sinf(x)", sinNs);
+
+  t0 = nowSec();
+  for (long k = 0; k < calls; k++) acc += GradientNoise::noise1(GradientNoise::fixed(k * 0.001f));
+  printf("%-28s %10.2f\n", "noise1(x)", (nowSec() - t0) * 1e9 / calls);
+
+  t0 = nowSec();
+  for (long k = 0; k < calls; k++) {
+    acc += GradientNoise::noise2(GradientNoise::fixed(k * 0.001f), GradientNoise::fixed(k * 0.0007f));
+  }
+  printf("%-28s %10.2f\n", "noise2(x,y)", (nowSec() - t0) * 1e9 / calls);
+
+  t0 = nowSec();
+  for (long k = 0; k < calls; k++) {
+    acc += GradientNoise::noise3(GradientNoise::fixed(k * 0.001f), GradientNoise::fixed(k * 0.0007f),
+                                 GradientNoise::fixed(k * 0.0003f));
+  }
+  printf("%-28s %10.2f\n", "noise3(x,y,z)", (nowSec() - t0) * 1e9 / calls);
+  g_sink = acc;
+}
+
+// ===== 수식 전체 =====
+struct FormulaPair {
+  const char* name;
+  const char* sines;   // 여러 sin 항의 합
+  const char* noise;   // 같은 용도의 노이즈 호출
+};
+
+static const FormulaPair kPairs[] = {
+  { "flicker (uniform)",
+    "sin(t*1.3)*0.5 + sin(t*2.9 + 1)*0.3 + sin(t*5.3 + 2)*0.2",
+    "noise1(t*2)" },
+  { "shimmer (per LED)",
+    "sin(theta*3 + t*1.3)*0.5 + sin(theta*5 - t*2.1)*0.3 + sin(theta*7 + t*3.7)*0.2",
+    "noise2(i*0.6, t*1.5)" },
+  { "seamless ring",
+    "sin(theta*2 + t*1.1)*0.4 + sin(theta*3 - t*1.7)*0.3 + sin(theta*5 + t*2.3)*0.2 + sin(theta - t*0.7)*0.1",
+    "noise3(cos(theta)*1.5, sin(theta)*1.5, t)" },
+  { "bio rhythm (val)",
+    "(sin(t*3 + theta) * cos(theta - t)) + 0.5",
+    "noise2(theta, t) + 0.5" },
+};
+
+// DynamicPattern::update와 같은 순서로 frames 프레임을 실행하고 LED당 평균 ns를 돌려준다
+static double benchFormula(const char* src, int numLeds, long frames, int& codeLen) {
+  static ExpressionEvaluator compiler;
+  static CompiledExpr code;
+  if (!compiler.compile(src, code)) {
+    fprintf(stderr, "compile failed: %s at position %d\n  %s\n", compiler.error(), compiler.errorPos(), src);
+    exit(1);
+  }
+  codeLen = code.codeLen - code.frameLen;
+
+  float inputs[EXPR_MAX_INPUTS];
+  ExprOscState osc[EXPR_MAX_OSC];
+  ExprFilterState filt[EXPR_MAX_FILTERS];
+  ExpressionEvaluator::resetOscillators(osc);
+  ExpressionEvaluator::resetFilters(filt);
+
+  float acc = 0;
+  double t0 = nowSec();
+  for (long f = 0; f < frames; f++) {
+    const uint32_t ms = (uint32_t)(f * 16);
+    const float t = ms * 0.001f;
+    ExpressionEvaluator::resolveInputs(code, inputs);
+    ExpressionEvaluator::advanceOscillators(code, osc, ms);
+    ExprContext frame = { 0.0f, t, 0, inputs, nullptr, osc, filt, 0.0f };
+    ExpressionEvaluator::advanceFilters(code, filt, frame, 0.016f);
+    for (int i = 0; i < numLeds; i++) {
+      ExprContext ctx = { (2.0f * VIBE_PI * i) / numLeds, t, i, inputs, nullptr, osc, filt, 0.0f };
+      acc += ExpressionEvaluator::run(code, ctx);
+    }
+  }
+  double ns = (nowSec() - t0) * 1e9 / ((double)frames * numLeds);
+  g_sink = acc;
+  return ns;
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  --leds N         LED count (default 12)\n"
+    "  --frames N       frames per formula (default 20000)\n"
+    "  --calls N        calls per kernel (default 2000000)\n",
+    argv0);
+}
+
+int main(int argc, char** argv) {
+  int numLeds = 12;
+  long frames = 20000;
+  long calls = 2000000;
+
+  for (int a = 1; a < argc; a++) {
+    const char* opt = argv[a];
+    if (a + 1 >= argc) { usage(argv[0]); return 2; }
+    const char* v = argv[++a];
+    if      (!strcmp(opt, "--leds"))   numLeds = atoi(v);
+    else if (!strcmp(opt, "--frames")) frames = atol(v);
+    else if (!strcmp(opt, "--calls"))  calls = atol(v);
+    else { usage(argv[0]); return 2; }
+  }
+  if (numLeds < 1 || frames < 1 || calls < 1) { usage(argv[0]); return 2; }
+
+  benchKernels(calls);
+
+  printf("\n%-20s %12s %6s %12s %6s %8s\n", "formula", "sines ns/LED", "ops", "noise ns/LED", "ops", "speedup");
+  for (const FormulaPair& p : kPairs) {
+    int sineOps, noiseOps;
+    double s = benchFormula(p.sines, numLeds, frames, sineOps);
+    double n = benchFormula(p.noise, numLeds, frames, noiseOps);
+    printf("%-20s %12.1f %6d %12.1f %6d %7.2fx\n", p.name, s, sineOps, n, noiseOps, s / n);
+  }
+  printf("\n(%d LEDs, %ld frames per formula; ops = per-LED instructions after compile-time optimization)\n",
+         numLeds, frames);
+  return 0;
+}
+
+#endif // ARDUINO
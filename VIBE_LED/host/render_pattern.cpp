@@ -0,0 +1,338 @@
+// 오프라인 패턴 렌더러 (호스트/Linux 전용 CLI)
+//
+// 장치에 패턴을 올리기 전에 같은 ExpressionEvaluator 코드로 프레임을 미리 렌더링한다.
+// 프레임 범위를 워커 스레드에 나눠 실시간보다 빠르게 렌더링하고,
+// InPort 값은 CSV 트레이스로 재생한다.
+//
+// 빌드:
+//   g++ -std=c++17 -O2 -pthread -I.. render_pattern.cpp -o render_pattern
+//
+// 사용 예:
+//   ./render_pattern --hue "t+theta" --sat 1 --val 1 --seconds 10 --out rainbow.ppm
+//   ./render_pattern --hue 3.0 --sat 1 --val "var_a*(sin(t*5)+1)/2" --inports audio.csv --out pulse.vled
+//   ./render_pattern --hue "t*speed+theta" --sat 1 --val 1 --param speed=3 --out fast.ppm
+//   ./render_pattern --hue 3.0 --sat 1 --val "smooth(var_a, 0.15)" --inports audio.csv --out smooth.ppm
+//
+// 출력 형식:
+//   raw : 16바이트 헤더 + 프레임별 RGB(NUM_LEDS*3 바이트)
+//         헤더 = "VLED" | u16 version(1) | u16 num_leds | u32 frame_count | f32 fps (리틀엔디언)
+//   ppm : P6 스트립 이미지 (가로 = LED, 세로 = 프레임)
+//
+// InPort CSV 형식:
+//   첫 줄은 헤더 "t,var_a,var_b,..." (t는 초), 이후 시간 순 정렬된 샘플.
+//   프레임 시각 이전의 마지막 샘플 값을 사용한다 (sample-and-hold).
+//
+// 참고: 장치는 FastLED의 CHSV → CRGB(rainbow) 변환을 쓰지만,
+// 여기서는 일반 HSV 스펙트럼 변환을 사용하므로 색상은 근사값이다.
+
+#ifndef ARDUINO   // 모듈 폴더째 펌웨어 빌드에 포함되어도 무시되도록
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "expression_evaluator.h"
+
+// ===== InPort 트레이스 재생 =====
+struct InPortTrace {
+  std::vector<std::string> names;           // 열 이름 (t 제외)
+  std::vector<double> times;                // 샘플 시각 (초)
+  std::vector<std::vector<float>> values;   // values[row][col]
+
+  bool load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    char line[1024];
+    bool header = true;
+    while (fgets(line, sizeof(line), f)) {
+      if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
+
+      std::vector<std::string> cells;
+      char* save = nullptr;
+      for (char* tok = strtok_r(line, ",\r\n", &save); tok; tok = strtok_r(nullptr, ",\r\n", &save)) {
+        while (*tok == ' ') tok++;
+        cells.push_back(tok);
+      }
+      if (cells.empty()) continue;
+
+      if (header) {
+        for (size_t c = 1; c < cells.size(); c++) names.push_back(cells[c]);
+        header = false;
+        continue;
+      }
+
+      times.push_back(atof(cells[0].c_str()));
+      std::vector<float> row(names.size(), 0.0f);
+      for (size_t c = 1; c < cells.size() && c - 1 < names.size(); c++) {
+        row[c - 1] = (float)atof(cells[c].c_str());
+      }
+      values.push_back(row);
+    }
+    fclose(f);
+    return !header;
+  }
+
+  float lookup(const char* name, double t) const {
+    int col = -1;
+    for (size_t c = 0; c < names.size(); c++) {
+      if (names[c] == name) { col = (int)c; break; }
+    }
+    if (col < 0 || times.empty() || t < times[0]) return NAN;
+
+    // t 이하의 마지막 샘플 (이진 탐색)
+    size_t lo = 0, hi = times.size();
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      if (times[mid] <= t) lo = mid; else hi = mid;
+    }
+    return values[lo][col];
+  }
+};
+
+static InPortTrace g_trace;
+static thread_local double g_frame_t = 0.0; // 스레드별 현재 프레임 시각
+
+// 펌웨어에서는 포트 레지스트리가 제공하는 함수
+float port_get_inport_value(const char* name) {
+  return g_trace.lookup(name, g_frame_t);
+}
+
+// ===== HSV → RGB (8비트 스펙트럼 변환) =====
+static void hsvToRgb(const HsvBytes& hsv, uint8_t* rgb) {
+  if (hsv.s == 0) {
+    rgb[0] = rgb[1] = rgb[2] = hsv.v;
+    return;
+  }
+  uint16_t h6 = (uint16_t)hsv.h * 6;           // 0 ~ 1530
+  uint8_t sector = h6 >> 8;                     // 0 ~ 5
+  uint8_t frac = h6 & 0xFF;
+  uint8_t v = hsv.v, s = hsv.s;
+  uint8_t p = (uint16_t)v * (255 - s) / 255;
+  uint8_t q = (uint16_t)v * (255 - (uint16_t)s * frac / 255) / 255;
+  uint8_t u = (uint16_t)v * (255 - (uint16_t)s * (255 - frac) / 255) / 255;
+  switch (sector) {
+    case 0:  rgb[0] = v; rgb[1] = u; rgb[2] = p; break;
+    case 1:  rgb[0] = q; rgb[1] = v; rgb[2] = p; break;
+    case 2:  rgb[0] = p; rgb[1] = v; rgb[2] = u; break;
+    case 3:  rgb[0] = p; rgb[1] = q; rgb[2] = v; break;
+    case 4:  rgb[0] = u; rgb[1] = p; rgb[2] = v; break;
+    default: rgb[0] = v; rgb[1] = p; rgb[2] = q; break;
+  }
+}
+
+// ===== 렌더링 =====
+struct RenderJob {
+  const char* hue = "0";
+  const char* sat = "1";
+  const char* val = "0.5";
+  CompiledExpr code[3];   // H, S, V (스레드 간 읽기 전용 공유)
+  char   paramNames[EXPR_MAX_UNIFORMS][EXPR_NAME_LEN];
+  float  params[EXPR_MAX_UNIFORMS];
+  uint8_t paramCount = 0;
+  int    numLeds = 12;
+  float  fps = 60.0f;
+  double start = 0.0;
+  long   frames = 600;
+};
+
+// [first, last) 프레임을 out 버퍼에 렌더링 (워커 스레드 하나 담당)
+static void renderRange(const RenderJob& job, long first, long last, uint8_t* out) {
+  const size_t frameBytes = (size_t)job.numLeds * 3;
+  float inputs[3][EXPR_MAX_INPUTS];
+  ExprOscState osc[3][EXPR_MAX_OSC];   // 스레드별 상태 (첫 프레임에서 정확한 값으로 초기화)
+  ExprFilterState filt[3][EXPR_MAX_FILTERS];
+  for (int c = 0; c < 3; c++) {
+    ExpressionEvaluator::resetOscillators(osc[c]);
+    ExpressionEvaluator::resetFilters(filt[c]);
+  }
+
+  // 상태 함수는 이전 프레임에 의존하므로, 앞 구간의 프레임 전처리만 다시 돌려 상태를 맞춘다
+  bool stateful = false;
+  for (int c = 0; c < 3; c++) stateful |= job.code[c].filterCount > 0;
+  uint32_t lastMs = 0;
+
+  for (long f = stateful ? 0 : first; f < last; f++) {
+    double t = job.start + (double)f / job.fps;
+    g_frame_t = t;
+    uint8_t* px = out + (size_t)f * frameBytes;
+
+    // DynamicPattern::update와 같은 계산
+    const uint32_t ms = (uint32_t)llround(t * 1000.0);
+    const float dt = (ms - lastMs) * 0.001f;
+    lastMs = ms;
+    for (int c = 0; c < 3; c++) {
+      ExpressionEvaluator::resolveInputs(job.code[c], inputs[c]);
+      ExpressionEvaluator::advanceOscillators(job.code[c], osc[c], ms);
+      ExprContext frame = { 0.0f, (float)t, 0, inputs[c], job.params, osc[c], filt[c], 0.0f };
+      ExpressionEvaluator::advanceFilters(job.code[c], filt[c], frame, dt);
+    }
+    if (f < first) continue;
+
+    for (int i = 0; i < job.numLeds; i++) {
+      float theta = (2.0f * VIBE_PI * i) / job.numLeds;
+      ExprContext ctx = { theta, (float)t, i, inputs[0], job.params, osc[0], filt[0], 0.0f };
+      float h = ExpressionEvaluator::run(job.code[0], ctx);
+      ctx.inputs = inputs[1];
+      ctx.osc = osc[1];
+      ctx.filters = filt[1];
+      float s = ExpressionEvaluator::run(job.code[1], ctx);
+      ctx.inputs = inputs[2];
+      ctx.osc = osc[2];
+      ctx.filters = filt[2];
+      float v = ExpressionEvaluator::run(job.code[2], ctx);
+      hsvToRgb(normalizeHsv(h, s, v), px + i * 3);
+    }
+  }
+}
+
+static void writeLE(FILE* f, uint32_t v, int bytes) {
+  for (int b = 0; b < bytes; b++) fputc((v >> (8 * b)) & 0xFF, f);
+}
+
+static bool writeRaw(const char* path, const RenderJob& job, const std::vector<uint8_t>& buf) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fwrite("VLED", 1, 4, f);
+  writeLE(f, 1, 2);                          // version
+  writeLE(f, (uint32_t)job.numLeds, 2);
+  writeLE(f, (uint32_t)job.frames, 4);
+  uint32_t fpsBits;
+  memcpy(&fpsBits, &job.fps, 4);
+  writeLE(f, fpsBits, 4);
+  fwrite(buf.data(), 1, buf.size(), f);
+  fclose(f);
+  return true;
+}
+
+static bool writePpm(const char* path, const RenderJob& job, const std::vector<uint8_t>& buf) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %ld\n255\n", job.numLeds, job.frames);
+  fwrite(buf.data(), 1, buf.size(), f);
+  fclose(f);
+  return true;
+}
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "Usage: %s --hue EXPR --sat EXPR --val EXPR [options]\n"
+    "  --leds N         LED count (default 12)\n"
+    "  --fps F          frame rate (default 60)\n"
+    "  --seconds S      duration in seconds (default 10)\n"
+    "  --frames N       frame count (overrides --seconds)\n"
+    "  --start T        start time t in seconds (default 0)\n"
+    "  --threads K      worker threads (default: hardware concurrency)\n"
+    "  --inports FILE   InPort trace CSV (t,var_a,...)\n"
+    "  --param NAME=V   pattern parameter (repeatable, max %d)\n"
+    "  --format raw|ppm output format (default: from extension, else raw)\n"
+    "  --out FILE       output file (omit to only measure throughput)\n",
+    argv0, EXPR_MAX_UNIFORMS);
+}
+
+int main(int argc, char** argv) {
+  RenderJob job;
+  double seconds = 10.0;
+  long frames = -1;
+  int threads = (int)std::thread::hardware_concurrency();
+  const char* inports = nullptr;
+  const char* format = nullptr;
+  const char* outPath = nullptr;
+
+  for (int a = 1; a < argc; a++) {
+    const char* opt = argv[a];
+    if (a + 1 >= argc) { usage(argv[0]); return 2; }
+    const char* v = argv[++a];
+    if      (!strcmp(opt, "--hue"))     job.hue = v;
+    else if (!strcmp(opt, "--sat"))     job.sat = v;
+    else if (!strcmp(opt, "--val"))     job.val = v;
+    else if (!strcmp(opt, "--leds"))    job.numLeds = atoi(v);
+    else if (!strcmp(opt, "--fps"))     job.fps = (float)atof(v);
+    else if (!strcmp(opt, "--seconds")) seconds = atof(v);
+    else if (!strcmp(opt, "--frames"))  frames = atol(v);
+    else if (!strcmp(opt, "--start"))   job.start = atof(v);
+    else if (!strcmp(opt, "--threads")) threads = atoi(v);
+    else if (!strcmp(opt, "--inports")) inports = v;
+    else if (!strcmp(opt, "--param")) {
+      const char* eq = strchr(v, '=');
+      size_t len = eq ? (size_t)(eq - v) : 0;
+      if (!eq || len == 0 || len >= EXPR_NAME_LEN || job.paramCount >= EXPR_MAX_UNIFORMS) { usage(argv[0]); return 2; }
+      memcpy(job.paramNames[job.paramCount], v, len);
+      job.paramNames[job.paramCount][len] = '\0';
+      job.params[job.paramCount++] = (float)atof(eq + 1);
+    }
+    else if (!strcmp(opt, "--format"))  format = v;
+    else if (!strcmp(opt, "--out"))     outPath = v;
+    else { usage(argv[0]); return 2; }
+  }
+
+  if (job.numLeds <= 0 || job.fps <= 0.0f) { usage(argv[0]); return 2; }
+  job.frames = (frames >= 0) ? frames : (long)(seconds * job.fps);
+  if (job.frames <= 0) { usage(argv[0]); return 2; }
+  if (threads < 1) threads = 1;
+  if (threads > job.frames) threads = (int)job.frames;
+
+  // 장치와 같은 규칙으로 컴파일 (오류 시 저장 거부와 동일)
+  static ExpressionEvaluator compiler;
+  const char* exprs[3] = { job.hue, job.sat, job.val };
+  static const char* const kChannel[3] = { "hue", "sat", "val" };
+  for (int c = 0; c < 3; c++) {
+    if (!compiler.compile(exprs[c], job.code[c], job.paramNames, job.paramCount)) {
+      fprintf(stderr, "%s: %s at position %d\n  %s\n", kChannel[c], compiler.error(), compiler.errorPos(), exprs[c]);
+      return 1;
+    }
+  }
+  fprintf(stderr, "[compile] eval stack h/s/v = %d/%d/%d, depth = %d/%d/%d, oscillators = %d/%d/%d, "
+          "stateful = %d/%d/%d\n",
+          job.code[0].maxStack, job.code[1].maxStack, job.code[2].maxStack,
+          job.code[0].depth, job.code[1].depth, job.code[2].depth,
+          job.code[0].oscCount, job.code[1].oscCount, job.code[2].oscCount,
+          job.code[0].filterCount, job.code[1].filterCount, job.code[2].filterCount);
+
+  if (inports && !g_trace.load(inports)) {
+    fprintf(stderr, "Failed to read InPort trace: %s\n", inports);
+    return 1;
+  }
+
+  if (!format) {
+    const char* dot = outPath ? strrchr(outPath, '.') : nullptr;
+    format = (dot && !strcmp(dot, ".ppm")) ? "ppm" : "raw";
+  }
+
+  std::vector<uint8_t> buf((size_t)job.frames * job.numLeds * 3);
+
+  // 프레임 범위를 스레드 수만큼 균등 분할
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  long chunk = (job.frames + threads - 1) / threads;
+  for (int w = 0; w < threads; w++) {
+    long first = w * chunk;
+    long last = (first + chunk < job.frames) ? first + chunk : job.frames;
+    if (first >= last) break;
+    workers.emplace_back(renderRange, std::cref(job), first, last, buf.data());
+  }
+  for (auto& th : workers) th.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  double fpsOut = job.frames / (elapsed > 0 ? elapsed : 1e-9);
+  fprintf(stderr, "[render] %ld frames x %d LEDs, %zu threads: %.3f s (%.0f fps, %.1fx realtime)\n",
+          job.frames, job.numLeds, workers.size(), elapsed, fpsOut, fpsOut / job.fps);
+
+  if (outPath) {
+    bool ok = !strcmp(format, "ppm") ? writePpm(outPath, job, buf) : writeRaw(outPath, job, buf);
+    if (!ok) {
+      fprintf(stderr, "Failed to write %s\n", outPath);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+#endif // ARDUINO
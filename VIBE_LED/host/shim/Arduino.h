@@ -0,0 +1,133 @@
+// 호스트 빌드용 Arduino 최소 구현 (stress_tools 전용)
+// 모듈 헤더가 쓰는 부분만 std 라이브러리로 흉내 낸다. 핀/인터럽트는 아무 일도 하지 않는다.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+#define PI 3.14159265358979f
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 3
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+template <class T, class L, class H>
+inline T constrain(T v, L lo, H hi) { return v < (T)lo ? (T)lo : (v > (T)hi ? (T)hi : v); }
+
+// Arduino String: 힙 할당 동작은 같고 API는 쓰는 부분만
+// concat()과 StringSumHelper는 실제 ArduinoJson의 Arduino String 지원(ARDUINOJSON_ENABLE_ARDUINO_STRING)이 쓴다.
+class String {
+public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  String(char c) : _s(1, c) {}
+  String(int v) : _s(std::to_string(v)) {}
+  String(unsigned v) : _s(std::to_string(v)) {}
+  String(long v) : _s(std::to_string(v)) {}
+  String(unsigned long v) : _s(std::to_string(v)) {}
+  String(float v) : String((double)v) {}
+  String(double v) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", v);   // Arduino 기본: 소수 둘째 자리
+    _s = buf;
+  }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned length() const { return (unsigned)_s.size(); }
+  bool reserve(unsigned n) { _s.reserve(n); return true; }
+  String substring(unsigned from, unsigned to) const {
+    if (from > _s.size()) from = (unsigned)_s.size();
+    if (to > _s.size()) to = (unsigned)_s.size();
+    return String(_s.substr(from, to > from ? to - from : 0));
+  }
+
+  bool concat(const char* o) { _s += o ? o : ""; return true; }
+  bool concat(const String& o) { _s += o._s; return true; }
+
+  String& operator+=(const String& o) { _s += o._s; return *this; }
+  String& operator+=(const char* o) { _s += o ? o : ""; return *this; }
+  String& operator+=(char c) { _s += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+  friend String operator+(const String& a, const char* b) { return String(a._s + (b ? b : "")); }
+  friend String operator+(const char* a, const String& b) { return String((a ? a : "") + b._s); }
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator!=(const String& o) const { return _s != o._s; }
+
+  const std::string& str() const { return _s; }
+
+private:
+  std::string _s;
+};
+
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+namespace host_shim {
+inline std::chrono::steady_clock::time_point bootTime() {
+  static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  return t0;
+}
+inline std::mt19937& rng() {
+  thread_local std::mt19937 gen(12345u + (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()));
+  return gen;
+}
+} // namespace host_shim
+
+inline unsigned long millis() {
+  return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - host_shim::bootTime()).count();
+}
+inline unsigned long micros() {
+  return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - host_shim::bootTime()).count();
+}
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+inline long random(long lo, long hi) {
+  if (hi <= lo) return lo;
+  return lo + (long)(host_shim::rng()() % (uint32_t)(hi - lo));
+}
+inline long random(long hi) { return random(0, hi); }
+inline void randomSeed(unsigned long seed) { host_shim::rng().seed((uint32_t)seed); }
+
+// 핀: 버튼은 풀업 상태(안 눌림)로 보인다
+inline void pinMode(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline void digitalWrite(int, int) {}
+inline void analogWrite(int, int) {}
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterruptArg(int, void (*)(void*), void*, int) {}
+
+struct HostSerial {
+  bool quiet = true;   // 툴 로그가 측정 출력을 덮지 않도록 기본은 끔
+  void printf(const char* fmt, ...) {
+    if (quiet) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+  }
+  void println(const char* s) { if (!quiet) fprintf(stderr, "%s\n", s); }
+};
+inline HostSerial Serial;
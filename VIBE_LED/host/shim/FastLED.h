@@ -0,0 +1,131 @@
+// 호스트 빌드용 FastLED 최소 구현 (stress_tools 전용)
+// 색 변환은 근사값이다. showLeds()는 WS2812 전송 시간(LED당 30us + 리셋 50us)만큼 점유하고
+// 호출 시각을 기록해 하니스가 프레임 간격을 잴 수 있게 한다.
+// FastLED.show()는 실제 라이브러리처럼 등록된 모든 컨트롤러를 차례로 전송한다.
+#pragma once
+
+#include "Arduino.h"
+
+#include <atomic>
+#include <vector>
+
+struct CRGB {
+  uint8_t r = 0, g = 0, b = 0;
+
+  CRGB() {}
+  CRGB(uint8_t r_, uint8_t g_, uint8_t b_) : r(r_), g(g_), b(b_) {}
+
+  static const CRGB Black;
+
+  CRGB& nscale8_video(uint8_t scale) {
+    uint8_t nz = scale != 0;
+    r = r ? (uint8_t)(((r * scale) >> 8) + nz) : 0;
+    g = g ? (uint8_t)(((g * scale) >> 8) + nz) : 0;
+    b = b ? (uint8_t)(((b * scale) >> 8) + nz) : 0;
+    return *this;
+  }
+
+  bool operator==(const CRGB& o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const CRGB& o) const { return !(*this == o); }
+};
+inline const CRGB CRGB::Black = CRGB(0, 0, 0);
+
+// HSV (8비트 색상환) → RGB: 6구간 스펙트럼 근사
+struct CHSV {
+  uint8_t h, s, v;
+  CHSV(uint8_t h_, uint8_t s_, uint8_t v_) : h(h_), s(s_), v(v_) {}
+
+  operator CRGB() const {
+    uint16_t sector = (uint16_t)h * 6;
+    uint8_t region = sector >> 8;
+    uint8_t frac = sector & 0xFF;
+    uint8_t p = (uint8_t)((v * (255 - s)) >> 8);
+    uint8_t q = (uint8_t)((v * (255 - ((s * frac) >> 8))) >> 8);
+    uint8_t t = (uint8_t)((v * (255 - ((s * (255 - frac)) >> 8))) >> 8);
+    switch (region) {
+      case 0:  return CRGB(v, t, p);
+      case 1:  return CRGB(q, v, p);
+      case 2:  return CRGB(p, v, t);
+      case 3:  return CRGB(p, q, v);
+      case 4:  return CRGB(t, p, v);
+      default: return CRGB(v, p, q);
+    }
+  }
+};
+
+typedef uint8_t fract8;
+
+// a → b 선형 보간 (amountOfB/256)
+inline uint8_t blend8(uint8_t a, uint8_t b, fract8 amountOfB) {
+  return (uint8_t)(((uint16_t)a * (256 - amountOfB) + (uint16_t)b * amountOfB) >> 8);
+}
+inline CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amountOfP2) {
+  return CRGB(blend8(p1.r, p2.r, amountOfP2), blend8(p1.g, p2.g, amountOfP2), blend8(p1.b, p2.b, amountOfP2));
+}
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return (uint8_t)(((uint16_t)i * (1 + (uint16_t)scale)) >> 8); }
+
+inline int16_t sin16(uint16_t theta) {
+  return (int16_t)lrintf(sinf(theta * (2.0f * PI / 65536.0f)) * 32767.0f);
+}
+
+inline void fill_solid(CRGB* leds, int n, const CRGB& c) {
+  for (int i = 0; i < n; i++) leds[i] = c;
+}
+
+class CLEDController;
+
+namespace host_shim {
+// show 호출마다 불리는 계측 훅 (렌더 스레드에서 호출)
+inline void (*onShow)(CLEDController* c, uint32_t us) = nullptr;
+} // namespace host_shim
+
+enum EOrder { RGB, GRB };
+struct WS2812B {};
+
+class CLEDController {
+public:
+  CLEDController(CRGB* leds, int n) : _leds(leds), _n(n) {}
+
+  // 전송 시간만큼 바쁜 대기 (장치에서도 RMT 전송 동안 렌더 태스크가 기다린다)
+  void showLeds(uint8_t brightness) {
+    (void)brightness;
+    const uint32_t wireUs = (uint32_t)_n * 30 + 50;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(wireUs);
+    uint32_t sum = 0;
+    for (int i = 0; i < _n; i++) sum += _leds[i].r + _leds[i].g + _leds[i].b;   // 버퍼를 실제로 읽는다
+    _checksum = sum;
+    while (std::chrono::steady_clock::now() < until) {}
+    _shows.fetch_add(1, std::memory_order_relaxed);
+    if (host_shim::onShow) host_shim::onShow(this, micros());
+  }
+
+  uint32_t shows() const { return _shows.load(std::memory_order_relaxed); }
+  int size() const { return _n; }
+
+private:
+  CRGB* _leds;
+  int _n;
+  uint32_t _checksum = 0;
+  std::atomic<uint32_t> _shows{0};
+};
+
+class CFastLED {
+public:
+  template <class TYPE, uint8_t PIN, EOrder ORDER>
+  CLEDController& addLeds(CRGB* leds, int n) {
+    CLEDController* c = new CLEDController(leds, n);   // 프로그램 수명 동안 유지
+    _controllers.push_back(c);
+    return *c;
+  }
+  void setBrightness(uint8_t scale) { _brightness = scale; }
+  void show() {
+    for (CLEDController* c : _controllers) c->showLeds(_brightness);
+  }
+  void clear() {}
+
+private:
+  std::vector<CLEDController*> _controllers;   // addLeds는 렌더 시작 전에만 불린다
+  uint8_t _brightness = 255;
+};
+inline CFastLED FastLED;
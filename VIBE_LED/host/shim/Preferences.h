@@ -0,0 +1,99 @@
+// 호스트 빌드용 Preferences(NVS) 최소 구현 (stress_tools 전용)
+// 메모리 맵에 저장하고, 쓰기마다 host_shim::nvsWriteUs 만큼 지연해 플래시 쓰기를 흉내 낸다.
+// 실제 Preferences처럼 내부 잠금이 없으므로 동시 호출은 호출 측이 직렬화해야 한다.
+// 반환값과 경계 동작(길이 0, 버퍼 부족, 형식 불일치)은 arduino-esp32 Preferences를 따른다.
+#pragma once
+
+#include "Arduino.h"
+
+#include <map>
+#include <vector>
+
+namespace host_shim {
+inline uint32_t nvsWriteUs = 0;
+} // namespace host_shim
+
+class Preferences {
+public:
+  bool begin(const char* ns, bool readOnly = false) {
+    _ns = ns ? ns : "";
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+  }
+  void end() { _started = false; }
+
+  bool isKey(const char* key) { return _started && key && _store().count(_key(key)) > 0; }
+
+  // ESP32 Preferences와 같은 반환값: 시작 전/읽기 전용/null 인자/길이 0이면 0을 돌려주고 아무것도 쓰지 않는다
+  size_t putBytes(const char* key, const void* value, size_t len) {
+    if (!_started || !key || !value || !len || _readOnly) return 0;
+    const uint8_t* p = static_cast<const uint8_t*>(value);
+    _write(key, Blob, std::vector<uint8_t>(p, p + len));
+    return len;
+  }
+  size_t getBytesLength(const char* key) {
+    const Entry* e = _find(key, Blob);
+    return e ? e->bytes.size() : 0;
+  }
+  // buf가 null이거나 maxLen이 0이면 저장된 길이, 저장된 값이 maxLen보다 길면 0 (복사하지 않음)
+  size_t getBytes(const char* key, void* buf, size_t maxLen) {
+    size_t len = getBytesLength(key);
+    if (!len || !buf || !maxLen) return len;
+    if (len > maxLen) return 0;
+    memcpy(buf, _find(key, Blob)->bytes.data(), len);
+    return len;
+  }
+
+  size_t putBool(const char* key, bool value) {
+    if (!_started || !key || _readOnly) return 0;
+    _write(key, U8, std::vector<uint8_t>(1, value ? 1 : 0));
+    return 1;
+  }
+  bool getBool(const char* key, bool def = false) {
+    const Entry* e = _find(key, U8);
+    return e ? e->bytes[0] == 1 : def;
+  }
+
+  size_t putString(const char* key, const String& value) {
+    if (!_started || !key || _readOnly) return 0;
+    _write(key, Str, std::vector<uint8_t>(value.c_str(), value.c_str() + value.length()));
+    return value.length();
+  }
+  String getString(const char* key, const String& def = String()) {
+    const Entry* e = _find(key, Str);
+    if (!e) return def;
+    return String(std::string(e->bytes.begin(), e->bytes.end()));
+  }
+
+private:
+  // NVS는 키마다 형식을 기록하므로 다른 형식으로 읽으면 없는 키처럼 동작한다
+  enum Type : uint8_t { U8, Str, Blob };
+  struct Entry {
+    Type type;
+    std::vector<uint8_t> bytes;
+  };
+
+  std::string _ns;
+  bool _started = false;
+  bool _readOnly = false;
+
+  static std::map<std::string, Entry>& _store() {
+    static std::map<std::string, Entry> s;
+    return s;
+  }
+  std::string _key(const char* key) const { return _ns + "/" + (key ? key : ""); }
+
+  const Entry* _find(const char* key, Type type) {
+    if (!_started || !key) return nullptr;
+    auto it = _store().find(_key(key));
+    return (it == _store().end() || it->second.type != type) ? nullptr : &it->second;
+  }
+
+  void _write(const char* key, Type type, std::vector<uint8_t> bytes) {
+    if (host_shim::nvsWriteUs) delayMicroseconds(host_shim::nvsWriteUs);
+    Entry& e = _store()[_key(key)];
+    e.type = type;
+    e.bytes = std::move(bytes);
+  }
+};
@@ -0,0 +1,314 @@
+// 호스트 빌드용 ArduinoJson(v7) 최소 구현 (stress_tools 전용)
+// 툴이 쓰는 부분(인자 읽기, 응답 문서 만들기, 직렬화)만 힙 트리로 구현한다.
+// 실제 라이브러리처럼 문서마다 힙 할당이 일어나므로 툴 경로의 할당 패턴도 비슷하다.
+// 실제 ArduinoJson v7로 하니스를 빌드·실행한 결과가 README에 기록될 때까지의 기본 빌드 경로.
+#pragma once
+
+#define HOST_JSON_FALLBACK 1   // 하니스가 어떤 JSON 구현으로 빌드됐는지 출력할 때 쓴다
+
+#include "Arduino.h"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace host_json {
+
+struct Node;
+typedef std::shared_ptr<Node> NodePtr;
+
+struct Node {
+  enum Kind : uint8_t { Null, Bool, Int, UInt, Float, Str, Raw, Obj, Arr } kind = Null;
+  bool        b = false;
+  int64_t     i = 0;
+  uint64_t    u = 0;
+  double      f = 0;
+  std::string s;
+  std::vector<std::pair<std::string, NodePtr>> members;
+  std::vector<NodePtr> items;
+
+  NodePtr find(const char* key) const {
+    for (const auto& m : members) if (m.first == key) return m.second;
+    return nullptr;
+  }
+  NodePtr member(const char* key) {
+    if (kind != Obj) { reset(); kind = Obj; }
+    NodePtr n = find(key);
+    if (n) return n;
+    n = std::make_shared<Node>();
+    members.emplace_back(key, n);
+    return n;
+  }
+  void reset() {
+    kind = Null;
+    s.clear();
+    members.clear();
+    items.clear();
+  }
+  bool isNumber() const { return kind == Int || kind == UInt || kind == Float; }
+  double number() const { return kind == Int ? (double)i : kind == UInt ? (double)u : kind == Float ? f : 0.0; }
+};
+
+inline void write(const Node& n, std::string& out);
+
+inline void writeString(const std::string& s, std::string& out) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:   out += c; break;
+    }
+  }
+  out += '"';
+}
+
+inline void write(const Node& n, std::string& out) {
+  char buf[32];
+  switch (n.kind) {
+    case Node::Null:  out += "null"; break;
+    case Node::Bool:  out += n.b ? "true" : "false"; break;
+    case Node::Int:   out += std::to_string(n.i); break;
+    case Node::UInt:  out += std::to_string(n.u); break;
+    case Node::Float: snprintf(buf, sizeof(buf), "%.9g", n.f); out += buf; break;
+    case Node::Str:   writeString(n.s, out); break;
+    case Node::Raw:   out += n.s; break;
+    case Node::Obj:
+      out += '{';
+      for (size_t k = 0; k < n.members.size(); k++) {
+        if (k) out += ',';
+        writeString(n.members[k].first, out);
+        out += ':';
+        write(*n.members[k].second, out);
+      }
+      out += '}';
+      break;
+    case Node::Arr:
+      out += '[';
+      for (size_t k = 0; k < n.items.size(); k++) {
+        if (k) out += ',';
+        write(*n.items[k], out);
+      }
+      out += ']';
+      break;
+  }
+}
+
+} // namespace host_json
+
+struct SerializedValue {
+  const char* json;
+};
+inline SerializedValue serialized(const char* json) { return { json }; }
+
+class JsonObjectConst;
+class JsonObject;
+class JsonArray;
+
+// 읽기 전용 값 (인자 조회)
+class JsonVariantConst {
+public:
+  JsonVariantConst() {}
+  explicit JsonVariantConst(host_json::NodePtr n) : _n(std::move(n)) {}
+
+  bool isNull() const { return !_n || _n->kind == host_json::Node::Null; }
+
+  int operator|(int def) const {
+    if (_n && _n->kind == host_json::Node::Int) return (int)_n->i;
+    if (_n && _n->kind == host_json::Node::UInt) return (int)_n->u;
+    return def;
+  }
+  float operator|(float def) const { return (_n && _n->isNumber()) ? (float)_n->number() : def; }
+  bool operator|(bool def) const { return (_n && _n->kind == host_json::Node::Bool) ? _n->b : def; }
+  const char* operator|(const char* def) const {
+    return (_n && _n->kind == host_json::Node::Str) ? _n->s.c_str() : def;
+  }
+
+  template <class T> T as() const;
+
+  JsonVariantConst operator[](const char* key) const {
+    return JsonVariantConst((_n && _n->kind == host_json::Node::Obj) ? _n->find(key) : nullptr);
+  }
+
+protected:
+  host_json::NodePtr _n;
+};
+
+class JsonString {
+public:
+  explicit JsonString(const std::string* s) : _s(s) {}
+  const char* c_str() const { return _s->c_str(); }
+private:
+  const std::string* _s;
+};
+
+class JsonPairConst {
+public:
+  JsonPairConst(const std::pair<std::string, host_json::NodePtr>* p) : _p(p) {}
+  JsonString key() const { return JsonString(&_p->first); }
+  JsonVariantConst value() const { return JsonVariantConst(_p->second); }
+private:
+  const std::pair<std::string, host_json::NodePtr>* _p;
+};
+
+class JsonObjectConst : public JsonVariantConst {
+public:
+  JsonObjectConst() {}
+  explicit JsonObjectConst(host_json::NodePtr n)
+    : JsonVariantConst((n && n->kind == host_json::Node::Obj) ? n : nullptr) {}
+
+  size_t size() const { return _n ? _n->members.size() : 0; }
+
+  class iterator {
+  public:
+    explicit iterator(const std::pair<std::string, host_json::NodePtr>* p) : _p(p) {}
+    JsonPairConst operator*() const { return JsonPairConst(_p); }
+    iterator& operator++() { ++_p; return *this; }
+    bool operator!=(const iterator& o) const { return _p != o._p; }
+  private:
+    const std::pair<std::string, host_json::NodePtr>* _p;
+  };
+  iterator begin() const { return iterator(_n ? _n->members.data() : nullptr); }
+  iterator end() const { return iterator(_n ? _n->members.data() + _n->members.size() : nullptr); }
+};
+
+template <> inline float JsonVariantConst::as<float>() const { return (_n && _n->isNumber()) ? (float)_n->number() : 0.0f; }
+template <> inline int JsonVariantConst::as<int>() const { return (_n && _n->isNumber()) ? (int)_n->number() : 0; }
+template <> inline const char* JsonVariantConst::as<const char*>() const {
+  return (_n && _n->kind == host_json::Node::Str) ? _n->s.c_str() : nullptr;
+}
+template <> inline JsonObjectConst JsonVariantConst::as<JsonObjectConst>() const { return JsonObjectConst(_n); }
+
+// 쓰기 가능한 값 (문서의 멤버/원소). 쓰기 시점에 부모 객체에 멤버를 만든다.
+class JsonVariant {
+public:
+  JsonVariant(host_json::NodePtr parent, std::string key) : _parent(std::move(parent)), _key(std::move(key)) {}
+  explicit JsonVariant(host_json::NodePtr node) : _node(std::move(node)) {}
+
+  template <class T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+  JsonVariant& operator=(T v) {
+    host_json::Node& n = _fresh();
+    if (std::is_signed<T>::value) { n.kind = host_json::Node::Int; n.i = (int64_t)v; }
+    else                          { n.kind = host_json::Node::UInt; n.u = (uint64_t)v; }
+    return *this;
+  }
+  JsonVariant& operator=(bool v)        { host_json::Node& n = _fresh(); n.kind = host_json::Node::Bool; n.b = v; return *this; }
+  JsonVariant& operator=(float v)       { return *this = (double)v; }
+  JsonVariant& operator=(double v)      { host_json::Node& n = _fresh(); n.kind = host_json::Node::Float; n.f = v; return *this; }
+  JsonVariant& operator=(const char* v) {
+    host_json::Node& n = _fresh();
+    n.kind = v ? host_json::Node::Str : host_json::Node::Null;
+    n.s = v ? v : "";
+    return *this;
+  }
+  JsonVariant& operator=(const String& v)  { host_json::Node& n = _fresh(); n.kind = host_json::Node::Str; n.s = v.str(); return *this; }
+  JsonVariant& operator=(SerializedValue v) { host_json::Node& n = _fresh(); n.kind = host_json::Node::Raw; n.s = v.json ? v.json : "null"; return *this; }
+
+  template <class T> T to();
+
+  JsonVariant operator[](const char* key) {
+    host_json::Node& n = _ensure();
+    if (n.kind != host_json::Node::Obj) { n.reset(); n.kind = host_json::Node::Obj; }
+    return JsonVariant(_node, key);
+  }
+
+protected:
+  host_json::NodePtr _parent;
+  std::string _key;
+  host_json::NodePtr _node;
+
+  host_json::Node& _ensure() {
+    if (!_node) _node = _parent->member(_key.c_str());
+    return *_node;
+  }
+  host_json::Node& _fresh() {
+    host_json::Node& n = _ensure();
+    n.reset();
+    return n;
+  }
+};
+
+class JsonObject {
+public:
+  explicit JsonObject(host_json::NodePtr n) : _n(std::move(n)) {}
+  JsonVariant operator[](const char* key) { return JsonVariant(_n, key); }
+  JsonVariant operator[](const String& key) { return JsonVariant(_n, key.str()); }
+  host_json::NodePtr node() const { return _n; }
+private:
+  host_json::NodePtr _n;
+};
+
+class JsonArray {
+public:
+  explicit JsonArray(host_json::NodePtr n) : _n(std::move(n)) {}
+
+  template <class T> T add();
+
+  template <class V>
+  bool add(const V& value) {
+    host_json::NodePtr item = std::make_shared<host_json::Node>();
+    _n->items.push_back(item);
+    JsonVariant v(item);
+    v = value;
+    return true;
+  }
+
+private:
+  host_json::NodePtr _n;
+};
+
+template <> inline JsonObject JsonArray::add<JsonObject>() {
+  host_json::NodePtr item = std::make_shared<host_json::Node>();
+  item->kind = host_json::Node::Obj;
+  _n->items.push_back(item);
+  return JsonObject(item);
+}
+
+template <> inline JsonObject JsonVariant::to<JsonObject>() {
+  host_json::Node& n = _fresh();
+  n.kind = host_json::Node::Obj;
+  return JsonObject(_node);
+}
+template <> inline JsonArray JsonVariant::to<JsonArray>() {
+  host_json::Node& n = _fresh();
+  n.kind = host_json::Node::Arr;
+  return JsonArray(_node);
+}
+
+class JsonDocument {
+public:
+  JsonDocument() : _root(std::make_shared<host_json::Node>()) {}
+
+  JsonVariant operator[](const char* key) {
+    if (_root->kind != host_json::Node::Obj) { _root->reset(); _root->kind = host_json::Node::Obj; }
+    return JsonVariant(_root, key);
+  }
+
+  template <class T> T as() const;
+  template <class T> T to();
+
+  void clear() { _root->reset(); }
+  const host_json::Node& root() const { return *_root; }
+
+private:
+  host_json::NodePtr _root;
+};
+
+template <> inline JsonObjectConst JsonDocument::as<JsonObjectConst>() const { return JsonObjectConst(_root); }
+template <> inline JsonObject JsonDocument::to<JsonObject>() {
+  _root->reset();
+  _root->kind = host_json::Node::Obj;
+  return JsonObject(_root);
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& out) {
+  std::string s;
+  host_json::write(doc.root(), s);
+  out = String(s);
+  return s.size();
+}
@@ -0,0 +1,29 @@
+// 호스트 빌드용 툴 인터페이스 (stress_tools 전용)
+// SDK의 ITool/ObservationBuilder와 같은 모양이며, 결과를 문자열로 보관한다. JSON은 실제 ArduinoJson을 쓴다.
+#pragma once
+
+#include <ArduinoJson.h>
+
+class ObservationBuilder {
+public:
+  void success(const char* payload) {
+    ok = true;
+    text = payload ? payload : "";
+  }
+  void error(const char* title, const char* msg) {
+    ok = false;
+    text = std::string(title ? title : "") + ": " + (msg ? msg : "");
+  }
+
+  bool ok = false;
+  std::string text;
+};
+
+class ITool {
+public:
+  virtual ~ITool() {}
+  virtual bool init() { return true; }
+  virtual const char* name() const = 0;
+  virtual void describe(JsonObject& tool) = 0;
+  virtual bool invoke(JsonObjectConst args, ObservationBuilder& out) = 0;
+};
@@ -0,0 +1,388 @@
+// 툴 호출 폭주 vs 렌더 루프 지터 스트레스 하니스 (호스트/Linux 전용 CLI)
+//
+// 펌웨어와 같은 툴 클래스(express_emotion_tool.h)와 EyeController 렌더 루프를 호스트 스레드로 돌린다.
+//   - 렌더 스레드: 장치의 렌더 태스크처럼 EyeController::runOnce()를 반복하고 남은 시간만큼 잔다.
+//   - 툴 스레드 N개: create_pattern / change_slot / slot_status / set_param / push_frame / profile_pattern을
+//     무작위로 몰아서(burst) 호출한다. 툴 인스턴스는 장치처럼 하나씩만 만들어 모든 스레드가 공유한다.
+// 링 전송(show) 간격과 렌더 작업 시간의 분포, 최악 정지 시간, 툴별 응답 시간을 출력하고
+// 최악 간격이 --max-stall-ms를 넘으면 종료 코드 1을 돌려준다 (회귀 게이트).
+//
+// Arduino/FastLED/NVS/SDK는 shim/의 호스트 구현을 쓴다. JSON은 기본으로 shim/json_fallback/의 최소 구현을 쓰고,
+// 헤더 전용인 실제 ArduinoJson(v7)으로도 빌드할 수 있다 ($ARDUINOJSON은 ArduinoJson 저장소 체크아웃 경로).
+// 실제 라이브러리 경로는 아직 빌드·실행 결과가 기록되지 않았다. 어느 쪽으로 빌드됐는지는 결과 첫 줄에 나온다.
+// NVS 쓰기 지연(--nvs-us)과 WS2812 전송 시간은 흉내 내지만 ESP32의 절대 시간은 아니므로
+// 분포의 모양과 최악값의 변화를 본다.
+//
+// 빌드:
+//   g++ -std=c++17 -O2 -pthread -Ishim -Ishim/json_fallback -I.. stress_tools.cpp -o stress_tools
+// 실제 ArduinoJson으로 빌드 (-Ishim/json_fallback 대신):
+//   git clone --depth 1 https://github.com/bblanchon/ArduinoJson.git $ARDUINOJSON
+//   g++ -std=c++17 -O2 -pthread -Ishim -I.. -I$ARDUINOJSON/src stress_tools.cpp -o stress_tools
+// 데이터 레이스 검사 (ThreadSanitizer, 레이스가 보고되면 종료 코드 66):
+//   g++ -std=c++17 -O1 -g -pthread -fsanitize=thread -Ishim -Ishim/json_fallback -I.. stress_tools.cpp -o stress_tools_tsan
+//
+// 사용 예:
+//   ./stress_tools                                   # 툴 스레드 4개, 5초, 링 2개
+//   ./stress_tools --threads 8 --seconds 20 --burst 16 --nvs-us 8000
+//   ./stress_tools_tsan --seconds 3
+
+#ifndef ARDUINO   // 모듈 폴더째 펌웨어 빌드에 포함되어도 무시되도록
+
+#define LED2_PIN      7     // 두 번째 링도 함께 렌더링 (LED 수가 다른 컨트롤러)
+#define LED2_NUM_LEDS 24
+
+// 실제 ArduinoJson으로 빌드할 때 장치처럼 Arduino String 경로를 쓴다 (shim/Arduino.h의 String, 최소 구현은 무시)
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "express_emotion_tool.h"
+
+// InPort: 오디오 레벨처럼 흔들리는 값 (모든 스레드에서 호출되므로 상태 없음)
+float port_get_inport_value(const char* name) {
+  float t = micros() * 1e-6f;
+  float k = (name && name[4] == 'b') ? 2.3f : 1.0f;
+  return 0.5f + 0.5f * sinf(t * 7.0f * k) * sinf(t * 0.9f);
+}
+
+namespace {
+
+struct Options {
+  int      threads = 4;
+  float    seconds = 5.0f;
+  int      burst = 8;         // 한 번에 몰아서 보내는 최대 호출 수
+  int      gapMs = 20;        // 버스트 사이 최대 대기
+  uint32_t nvsUs = 4000;      // NVS 쓰기 1회 지연
+  float    maxStallMs = 50.0f;
+  bool     verbose = false;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double usSince(Clock::time_point t0) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+// ===== 렌더 측 계측 (렌더 스레드에서만 기록) =====
+struct RenderLog {
+  const CLEDController* rings[EYE_MAX_CONTROLLERS] = {};
+  uint32_t lastShowUs[EYE_MAX_CONTROLLERS] = {};
+  std::vector<double> intervalMs;   // 링별 연속 show 간격
+  std::vector<double> workUs;       // 프레임을 렌더링한 runOnce() 한 번의 시간
+  std::atomic<uint32_t> shows{0};
+  bool recording = false;
+};
+RenderLog g_render;
+
+void onShow(CLEDController* c, uint32_t us) {
+  g_render.shows.fetch_add(1, std::memory_order_relaxed);
+  if (!g_render.recording) return;
+  int k = 0;
+  while (k < EYE_MAX_CONTROLLERS && g_render.rings[k] && g_render.rings[k] != c) k++;
+  if (k == EYE_MAX_CONTROLLERS) return;
+  g_render.rings[k] = c;
+  if (g_render.lastShowUs[k]) g_render.intervalMs.push_back((us - g_render.lastShowUs[k]) / 1000.0);
+  g_render.lastShowUs[k] = us;
+}
+
+void renderLoop(std::atomic<bool>& stop) {
+  g_render.recording = true;
+  while (!stop.load(std::memory_order_relaxed)) {
+    uint32_t before = g_render.shows.load(std::memory_order_relaxed);
+    Clock::time_point t0 = Clock::now();
+    uint32_t wait = EyeController::runOnce();
+    double us = usSince(t0);
+    if (g_render.shows.load(std::memory_order_relaxed) != before) g_render.workUs.push_back(us);
+    // 장치: ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait ? wait : 1))
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait ? wait : 1));
+  }
+}
+
+// ===== 툴 측 =====
+enum ToolId { T_CREATE, T_CHANGE, T_STATUS, T_SET_PARAM, T_PUSH, T_PROFILE, T_COUNT };
+const char* const kToolNames[T_COUNT] = {
+  "create_pattern", "change_slot", "slot_status", "set_param", "push_frame", "profile_pattern"
+};
+const int kToolWeights[T_COUNT] = { 20, 25, 25, 15, 12, 3 };
+
+struct Tools {
+  CreatePatternTool  create;
+  ChangeSlotTool     change;
+  SlotStatusTool     status;
+  SetParamTool       setParam;
+  PushFrameTool      push;
+  ProfilePatternTool profile;
+
+  ITool* get(int id) {
+    switch (id) {
+      case T_CREATE:    return &create;
+      case T_CHANGE:    return &change;
+      case T_STATUS:    return &status;
+      case T_SET_PARAM: return &setParam;
+      case T_PUSH:      return &push;
+      default:          return &profile;
+    }
+  }
+};
+
+struct Formula {
+  const char* name;
+  const char* hue;
+  const char* sat;
+  const char* val;
+  const char* param;    // 선언할 파라미터 (없으면 nullptr)
+};
+
+const Formula kFormulas[] = {
+  { "Rainbow", "t*0.5+theta", "1", "(sin(t*3+theta)+1)/2", nullptr },
+  { "Speedy",  "t*speed+theta", "1", "0.5+0.5*sin(theta*3-t*speed)", "speed" },
+  { "Audio",   "3.0", "1", "envelope(var_a, 0.02, 0.3)", nullptr },
+  { "Smooth",  "smooth(var_b, 0.2)*pi", "1", "0.3+0.7*smooth(var_a, 0.1)", nullptr },
+  { "Flow",    "noise2(i*0.6, t)*pi", "1", "max(0,1-abs(mod(theta-t*gain,2*pi)))", "gain" },
+  { "Police",  "sin(t*10)>0 ? 0 : 4.2", "1", "1", nullptr },
+  { "Broken",  "sin(t*", "1", "1", nullptr },   // 컴파일 오류 경로
+};
+
+std::string base64(const std::vector<uint8_t>& bytes) {
+  static const char kAlpha[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  uint32_t acc = 0;
+  int bits = 0;
+  for (uint8_t b : bytes) {
+    acc = (acc << 8) | b;
+    bits += 8;
+    while (bits >= 6) {
+      bits -= 6;
+      out += kAlpha[(acc >> bits) & 0x3F];
+    }
+  }
+  if (bits > 0) out += kAlpha[(acc << (6 - bits)) & 0x3F];
+  while (out.size() % 4) out += '=';
+  return out;
+}
+
+struct ToolLog {
+  std::vector<double> latencyUs[T_COUNT];
+  uint32_t errors[T_COUNT] = {};
+};
+
+// 무작위 인자로 툴 하나 호출
+void callTool(Tools& tools, int id, ToolLog& log, const std::string& frame, bool verbose) {
+  JsonDocument args;
+  switch (id) {
+    case T_CREATE: {
+      const Formula& f = kFormulas[random(0, sizeof(kFormulas) / sizeof(kFormulas[0]))];
+      args["slot"] = (int)random(1, 6);
+      args["name"] = f.name;
+      args["hue"] = f.hue;
+      args["saturation"] = f.sat;
+      args["brightness"] = f.val;
+      if (f.param) {
+        auto params = args["params"].to<JsonObject>();
+        params[f.param] = random(5, 40) / 10.0f;
+      }
+    } break;
+    case T_CHANGE: {
+      static const int kSlots[] = { 0, 1, 2, 3, 4, 5, 1, 2, 3, 6, 7, 8, 9, 10, 11 };
+      int slot = kSlots[random(0, sizeof(kSlots) / sizeof(kSlots[0]))];
+      static const char* const kTargets[] = { "", "", "eye2", "all" };
+      args["slot"] = slot;
+      args["target"] = kTargets[random(0, 4)];
+      if (random(0, 5) == 0) args["duration"] = random(1, 20) / 10.0f;
+      if (random(0, 3) == 0) args["fade"] = random(0, 10) / 10.0f;   // 0 = 즉시 전환
+      if (slot >= PatternLibrary::NATIVE_SLOT_BASE && random(0, 2) == 0) {
+        auto params = args["params"].to<JsonObject>();
+        params[PatternLibrary::getNativeKernel(slot)->paramNames[0]] = random(5, 50) / 10.0f;
+      }
+    } break;
+    case T_STATUS:
+      break;
+    case T_SET_PARAM: {
+      static const int kSlots[] = { 1, 2, 3, 4, 5, 8, 9, 10, 11 };
+      int slot = kSlots[random(0, sizeof(kSlots) / sizeof(kSlots[0]))];
+      args["slot"] = slot;
+      auto params = args["params"].to<JsonObject>();
+      const NativeKernelInfo* info = PatternLibrary::getNativeKernel(slot);
+      params[info ? info->paramNames[0] : (random(0, 2) ? "speed" : "gain")] = random(5, 40) / 10.0f;
+      if (random(0, 6) == 0) args["persist"] = true;
+    } break;
+    case T_PUSH:
+      args["rgb"] = frame.c_str();
+      break;
+    case T_PROFILE:
+      args["frames"] = (int)random(2, 6);
+      args["top"] = 3;
+      break;
+  }
+
+  ObservationBuilder out;
+  Clock::time_point t0 = Clock::now();
+  tools.get(id)->invoke(args.as<JsonObjectConst>(), out);
+  log.latencyUs[id].push_back(usSince(t0));
+  if (!out.ok) log.errors[id]++;
+  if (verbose) fprintf(stderr, "[%s] %s\n", kToolNames[id], out.text.c_str());
+}
+
+void toolLoop(Tools& tools, const Options& opt, std::atomic<bool>& stop, ToolLog& log) {
+  int totalWeight = 0;
+  for (int w : kToolWeights) totalWeight += w;
+
+  std::vector<uint8_t> rgb((size_t)EyeController::instance().numLeds() * 3);
+  for (size_t k = 0; k < rgb.size(); k++) rgb[k] = (uint8_t)random(0, 256);
+  const std::string frame = base64(rgb);
+
+  while (!stop.load(std::memory_order_relaxed)) {
+    int n = (int)random(1, opt.burst + 1);
+    for (int k = 0; k < n && !stop.load(std::memory_order_relaxed); k++) {
+      int pick = (int)random(0, totalWeight);
+      int id = 0;
+      while (pick >= kToolWeights[id]) pick -= kToolWeights[id++];
+      callTool(tools, id, log, frame, opt.verbose);
+    }
+    if (opt.gapMs > 0) delay(random(0, opt.gapMs + 1));
+  }
+}
+
+// ===== 보고 =====
+double percentile(std::vector<double>& v, double p) {
+  if (v.empty()) return 0;
+  size_t k = (size_t)(p * (v.size() - 1) + 0.5);
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+void printDist(const char* label, std::vector<double> v) {
+  if (v.empty()) {
+    printf("  %-18s (no samples)\n", label);
+    return;
+  }
+  double mx = *std::max_element(v.begin(), v.end());
+  printf("  %-18s %9.2f %9.2f %9.2f %9.2f %9.2f\n", label,
+         percentile(v, 0.50), percentile(v, 0.90), percentile(v, 0.99), percentile(v, 0.999), mx);
+}
+
+void usage(const char* argv0) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  --threads N        tool threads (default 4)\n"
+    "  --seconds S        run time (default 5)\n"
+    "  --burst N          max calls per burst (default 8)\n"
+    "  --gap-ms N         max pause between bursts (default 20)\n"
+    "  --nvs-us N         simulated NVS write latency per key (default 4000)\n"
+    "  --max-stall-ms X   fail if any ring's frame interval exceeds X (default 50)\n"
+    "  --verbose          print every tool response\n",
+    argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  for (int a = 1; a < argc; a++) {
+    const char* o = argv[a];
+    if (!strcmp(o, "--verbose")) { opt.verbose = true; continue; }
+    if (a + 1 >= argc) { usage(argv[0]); return 2; }
+    const char* v = argv[++a];
+    if      (!strcmp(o, "--threads"))      opt.threads = atoi(v);
+    else if (!strcmp(o, "--seconds"))      opt.seconds = (float)atof(v);
+    else if (!strcmp(o, "--burst"))        opt.burst = atoi(v);
+    else if (!strcmp(o, "--gap-ms"))       opt.gapMs = atoi(v);
+    else if (!strcmp(o, "--nvs-us"))       opt.nvsUs = (uint32_t)atol(v);
+    else if (!strcmp(o, "--max-stall-ms")) opt.maxStallMs = (float)atof(v);
+    else { usage(argv[0]); return 2; }
+  }
+  if (opt.threads < 1 || opt.seconds <= 0 || opt.burst < 1 || opt.gapMs < 0) { usage(argv[0]); return 2; }
+
+  host_shim::onShow = &onShow;
+  host_shim::nvsWriteUs = opt.nvsUs;
+
+  // 장치처럼 툴 인스턴스는 하나씩, init()에서 컨트롤러/라이브러리 초기화
+  static Tools tools;
+  for (int id = 0; id < T_COUNT; id++) tools.get(id)->init();
+
+  // 시작 상태: 패턴 몇 개를 저장하고 기본 링에서 재생
+  {
+    ToolLog warm;
+    for (int slot = 1; slot <= PatternLibrary::USER_SLOTS; slot++) {
+      JsonDocument args;
+      const Formula& f = kFormulas[slot - 1];
+      args["slot"] = slot;
+      args["name"] = f.name;
+      args["hue"] = f.hue;
+      args["saturation"] = f.sat;
+      args["brightness"] = f.val;
+      if (f.param) args["params"].to<JsonObject>()[f.param] = 2.0f;
+      ObservationBuilder out;
+      tools.create.invoke(args.as<JsonObjectConst>(), out);
+      if (!out.ok) { fprintf(stderr, "seed failed: %s\n", out.text.c_str()); return 2; }
+    }
+    JsonDocument args;
+    args["slot"] = 2;
+    args["target"] = "all";
+    ObservationBuilder out;
+    tools.change.invoke(args.as<JsonObjectConst>(), out);
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<ToolLog> logs(opt.threads);
+  std::thread render(renderLoop, std::ref(stop));
+  std::vector<std::thread> workers;
+  for (int k = 0; k < opt.threads; k++) {
+    workers.emplace_back(toolLoop, std::ref(tools), std::cref(opt), std::ref(stop), std::ref(logs[k]));
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(opt.seconds));
+  stop = true;
+  for (std::thread& w : workers) w.join();
+  render.join();
+
+  // ----- 결과 -----
+  const uint16_t tickMs = EyeController::instance().cfg.tickMs;
+  double worst = g_render.intervalMs.empty() ? 0
+               : *std::max_element(g_render.intervalMs.begin(), g_render.intervalMs.end());
+  size_t late = 0;
+  for (double ms : g_render.intervalMs) if (ms > tickMs * 1.5) late++;
+
+#ifdef HOST_JSON_FALLBACK
+  printf("json: shim/json_fallback (not the real ArduinoJson)\n");
+#else
+  printf("json: ArduinoJson %s\n", ARDUINOJSON_VERSION);
+#endif
+  printf("render: %zu frames on %u rings in %.1f s (tick %u ms), %d tool threads, NVS write %u us\n",
+         g_render.workUs.size(), (unsigned)EyeController::count(), opt.seconds, tickMs,
+         opt.threads, (unsigned)opt.nvsUs);
+  printf("  %-18s %9s %9s %9s %9s %9s\n", "", "p50", "p90", "p99", "p99.9", "max");
+  printDist("frame interval ms", g_render.intervalMs);
+  printDist("render work us", g_render.workUs);
+  printf("  late frames (> %.0f ms): %zu of %zu\n", tickMs * 1.5, late, g_render.intervalMs.size());
+
+  printf("\n  %-18s %7s %7s %10s %10s %10s\n", "tool", "calls", "errors", "p50 us", "p99 us", "max us");
+  for (int id = 0; id < T_COUNT; id++) {
+    std::vector<double> all;
+    uint32_t errors = 0;
+    for (ToolLog& l : logs) {
+      all.insert(all.end(), l.latencyUs[id].begin(), l.latencyUs[id].end());
+      errors += l.errors[id];
+    }
+    double mx = all.empty() ? 0 : *std::max_element(all.begin(), all.end());
+    double p50 = percentile(all, 0.5), p99 = percentile(all, 0.99);
+    printf("  %-18s %7zu %7u %10.0f %10.0f %10.0f\n", kToolNames[id], all.size(), (unsigned)errors, p50, p99, mx);
+  }
+
+  bool pass = worst <= opt.maxStallMs;
+  printf("\nworst frame interval %.2f ms (limit %.1f ms): %s\n", worst, opt.maxStallMs, pass ? "PASS" : "FAIL");
+  return pass ? 0 : 1;
+}
+
+#endif // ARDUINO
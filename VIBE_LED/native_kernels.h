@@ -0,0 +1,132 @@
+#pragma once
+#include <Arduino.h>
+#include <FastLED.h>
+
+#ifndef NUM_LEDS
+#define NUM_LEDS 12
+#endif
+
+// 네이티브 패턴 커널
+// 자주 쓰는 레시피(rainbow, comet, police, pulse)를 문자열 인터프리터 대신
+// LED 개수(N)로 특수화된 정수 연산 코드로 실행한다.
+//
+// 각도는 16비트 고정소수점(65536 = 2π)을 사용하고, 시간 의존 위상은 프레임당 한 번만 계산한다.
+// 파라미터 단위는 수식 레시피와 같다 (속도 = rad/s, 색상 = 라디안).
+
+#define NATIVE_MAX_PARAMS 4
+
+struct NativeKernelInfo {
+  const char* name;
+  uint8_t     paramCount;
+  const char* paramNames[NATIVE_MAX_PARAMS];
+  float       defaults[NATIVE_MAX_PARAMS];
+  void (*render)(CRGB* leds, uint32_t ms, const float* params);
+};
+
+// 링 기하 정보 (N에 대해 컴파일 타임 특수화)
+template <uint16_t N>
+struct RingGeometry {
+  static constexpr uint32_t THETA_STEP = 65536UL / N;  // LED 간 각도 (Q16)
+
+  static uint16_t theta16(uint16_t i) { return (uint16_t)(i * THETA_STEP); }
+
+  // 눈꺼풀 높이 h = (cos(θ)+1)/2, 맨 위 LED로부터의 거리(di)별 테이블
+  // 함수 지역 정적 객체의 초기화는 C++11부터 스레드 안전 (링마다 다른 태스크에서 불려도 한 번만 채워짐)
+  static const float* lidHeights() {
+    struct Table {
+      float h[N];
+      Table() {
+        for (uint16_t di = 0; di < N; di++) {
+          h[di] = (cosf((2.0f * PI) * ((float)di / (float)N)) + 1.0f) * 0.5f;
+        }
+      }
+    };
+    static const Table table;
+    return table.h;
+  }
+};
+
+namespace native_detail {
+
+// rad/s → 프레임 시각(ms)의 Q16 위상
+inline uint16_t phase16(uint32_t ms, float radPerSec) {
+  int64_t rate = (int64_t)(radPerSec * (65536.0f / (2.0f * PI)));  // Q16 turns/s
+  return (uint16_t)(((int64_t)ms * rate) / 1000);
+}
+
+// 라디안 색상 → 8비트 hue
+inline uint8_t hue8(float rad) {
+  float turns = rad / (2.0f * PI);
+  turns -= floorf(turns);
+  return (uint8_t)(turns * 255);
+}
+
+inline uint8_t unit8(float v) {
+  if (v <= 0.0f) return 0;
+  if (v >= 1.0f) return 255;
+  return (uint8_t)(v * 255);
+}
+
+} // namespace native_detail
+
+template <uint16_t N>
+struct NativeKernels {
+  typedef RingGeometry<N> Geo;
+
+  // hue = t*speed + theta, sat, val
+  static void rainbow(CRGB* leds, uint32_t ms, const float* p) {
+    uint8_t base = native_detail::phase16(ms, p[0]) >> 8;
+    uint8_t sat = native_detail::unit8(p[1]);
+    uint8_t val = native_detail::unit8(p[2]);
+    for (uint16_t i = 0; i < N; i++) {
+      leds[i] = CHSV(base + (uint8_t)(Geo::theta16(i) >> 8), sat, val);
+    }
+  }
+
+  // 머리가 speed(rad/s)로 회전하고 tail(rad) 길이의 꼬리가 선형 감쇠
+  static void comet(CRGB* leds, uint32_t ms, const float* p) {
+    uint16_t head = native_detail::phase16(ms, p[0]);
+    uint8_t hue = native_detail::phase16(ms, p[1]) >> 8;
+    float tailRad = (p[2] > 0.01f) ? p[2] : 0.01f;
+    uint32_t tail16 = (uint32_t)(tailRad * (65536.0f / (2.0f * PI)));
+    if (tail16 > 65535) tail16 = 65535;
+    for (uint16_t i = 0; i < N; i++) {
+      uint16_t behind = head - Geo::theta16(i);        // 머리 뒤쪽 각거리 (mod 2π)
+      uint8_t val = (behind >= tail16) ? 0 : (uint8_t)(255 - (behind * 255UL) / tail16);
+      leds[i] = CHSV(hue, 255, val);
+    }
+  }
+
+  // 빨강/파랑 교대 + 회전 스트로브
+  static void police(CRGB* leds, uint32_t ms, const float* p) {
+    bool red = sin16(native_detail::phase16(ms, p[0])) > 0;
+    uint8_t hue = red ? 0 : native_detail::hue8(4.2f);
+    uint16_t strobe = native_detail::phase16(ms, p[1]);
+    for (uint16_t i = 0; i < N; i++) {
+      bool on = sin16(strobe + Geo::theta16(i)) > 0;
+      leds[i] = CHSV(hue, 255, on ? 255 : 0);
+    }
+  }
+
+  // 전체 밝기가 (sin(t*speed)+1)/2 로 숨쉬기, floor = 최소 밝기
+  static void pulse(CRGB* leds, uint32_t ms, const float* p) {
+    uint8_t hue = native_detail::hue8(p[0]);
+    uint8_t wave = (uint8_t)((sin16(native_detail::phase16(ms, p[1])) + 32768) >> 8);
+    uint8_t lo = native_detail::unit8(p[2]);
+    uint8_t val = lo + scale8(wave, 255 - lo);
+    CRGB c = CHSV(hue, 255, val);
+    for (uint16_t i = 0; i < N; i++) leds[i] = c;
+  }
+
+  static constexpr uint8_t COUNT = 4;
+
+  static const NativeKernelInfo* table() {
+    static const NativeKernelInfo kTable[COUNT] = {
+      { "rainbow", 3, { "speed", "saturation", "brightness" }, { 1.0f, 1.0f, 1.0f }, &rainbow },
+      { "comet",   3, { "speed", "hue_speed", "tail" },        { 5.0f, 0.5f, 1.0f }, &comet },
+      { "police",  2, { "flip_speed", "strobe_speed" },        { 10.0f, 20.0f },     &police },
+      { "pulse",   3, { "hue", "speed", "floor" },             { 3.0f, 2.0f, 0.0f }, &pulse },
+    };
+    return kTable;
+  }
+};
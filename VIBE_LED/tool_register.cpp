@@ -8,6 +8,9 @@ void register_tools(ToolRegistry& reg, const ToolConfig& cfg) {
   reg.add(new CreatePatternTool());
   reg.add(new ChangeSlotTool());
   reg.add(new SlotStatusTool());
+  reg.add(new SetParamTool());
+  reg.add(new ProfilePatternTool());
+  reg.add(new PushFrameTool());
 }
 
 